@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "../include/parser.hpp"
+#include "workload.hpp"
+
+/**
+ * 基准测试程序
+ * 按参数生成负载后在进程内逐条交给 parser 执行（输出写到 /dev/null），
+ * 统计每类命令的吞吐量与延迟分位数，以 JSON 输出到标准输出。
+ * 加 --dump 时只把生成的命令序列输出到标准输出，可作为独立的数据生成器使用。
+ * 加 --replay 时改为测量事件日志回放：对 --workers 列出的每个线程数各回放 --repeat 次，
+ * 给出最短耗时与相对第一个线程数的加速比；日志取自 --journal，缺省时先执行生成的负载写出临时日志。
+ */
+namespace
+{
+    const char *commandName(TokenType t)
+    {
+        switch (t)
+        {
+            case TokenType::ADDTEAM:
+                return "ADDTEAM";
+            case TokenType::START:
+                return "START";
+            case TokenType::SUBMIT:
+                return "SUBMIT";
+            case TokenType::FLUSH:
+                return "FLUSH";
+            case TokenType::FREEZE:
+                return "FREEZE";
+            case TokenType::SCROLL:
+                return "SCROLL";
+            case TokenType::SCROLL_PREVIEW:
+                return "SCROLL_PREVIEW";
+            case TokenType::QUERY_RANKING:
+                return "QUERY_RANKING";
+            case TokenType::QUERY_SUBMISSION:
+                return "QUERY_SUBMISSION";
+            case TokenType::QUERY_LIVE_RANKING:
+                return "QUERY_LIVE_RANKING";
+            case TokenType::QUERY_HISTORY:
+                return "QUERY_HISTORY";
+            case TokenType::QUERY_BOARD:
+                return "QUERY_BOARD";
+            case TokenType::STATS:
+                return "STATS";
+            case TokenType::CHECKPOINT:
+                return "CHECKPOINT";
+            case TokenType::END:
+                return "END";
+            default:
+                return "UNKNOWN";
+        }
+    }
+
+    /// 已排序样本的 q 分位数（最近秩法）
+    uint64_t percentile(const std::vector<uint64_t> &sorted, double q)
+    {
+        if (sorted.empty())
+            return 0;
+        size_t idx = static_cast<size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(idx, sorted.size() - 1)];
+    }
+
+    bool parseOption(std::string_view arg, std::string_view name, std::string_view &value)
+    {
+        if (arg.size() <= name.size() + 3 || arg.substr(0, 2) != "--" || arg.substr(2, name.size()) != name ||
+            arg[name.size() + 2] != '=')
+            return false;
+        value = arg.substr(name.size() + 3);
+        return true;
+    }
+
+    void usage(const char *prog)
+    {
+        std::fprintf(stderr,
+                     "usage: %s [--worst-case] [--teams=N] [--problems=M] [--duration=T] [--ops=K] [--seed=S]\n"
+                     "          [--flush=P] [--freeze=P] [--scroll=P] [--query=P] [--ac=P] [--dump]\n"
+                     "          [--replay [--journal=<file>] [--workers=W1,W2,...] [--repeat=R]]\n",
+                     prog);
+    }
+
+    /// 逗号分隔的正整数列表，格式不符时返回空
+    std::vector<int> parseList(std::string_view v)
+    {
+        std::vector<int> list;
+        while (!v.empty())
+        {
+            size_t comma = std::min(v.find(','), v.size());
+            int x = std::atoi(std::string(v.substr(0, comma)).c_str());
+            if (x <= 0)
+                return {};
+            list.push_back(x);
+            v.remove_prefix(std::min(comma + 1, v.size()));
+        }
+        return list;
+    }
+
+    /// 执行生成的负载并写出事件日志，返回日志路径，失败时返回空串
+    std::string writeJournal(const std::vector<command> &cmds, int devnull)
+    {
+        const char *dir = std::getenv("TMPDIR");
+        std::string path = std::string(dir && *dir ? dir : "/tmp") + "/bench-replay-XXXXXX";
+        int fd = ::mkstemp(path.data());
+        if (fd < 0)
+            return std::string();
+        ::close(fd);
+        parser p;
+        p.set_output_fd(devnull);
+        if (!p.open_journal(path.c_str()))
+        {
+            ::unlink(path.c_str());
+            return std::string();
+        }
+        for (const command &c: cmds)
+            p.execute(c.line);
+        return path; // p 析构时写出剩余的日志记录
+    }
+
+    /**
+     * 回放模式：对每个线程数各回放 repeat 次，每次在新的 parser 上从头回放
+     * 线程池在计时之前建立，只计 replay_journal 本身
+     */
+    int runReplay(const char *path, const std::vector<int> &workerCounts, int repeat, int devnull)
+    {
+        using clock = std::chrono::steady_clock;
+        std::vector<double> best(workerCounts.size());
+        std::vector<double> mean(workerCounts.size());
+        long long records = 0;
+        for (size_t i = 0; i < workerCounts.size(); ++i)
+        {
+            double bestSeconds = 0;
+            double sum = 0;
+            for (int r = 0; r < repeat; ++r)
+            {
+                parser p;
+                p.set_output_fd(devnull);
+                p.set_workers(workerCounts[i]);
+                auto t0 = clock::now();
+                records = p.replay_journal(path);
+                auto t1 = clock::now();
+                if (records < 0)
+                {
+                    std::fprintf(stderr, "cannot replay journal: %s\n", path);
+                    return 1;
+                }
+                double seconds = std::chrono::duration<double>(t1 - t0).count();
+                bestSeconds = r == 0 ? seconds : std::min(bestSeconds, seconds);
+                sum += seconds;
+            }
+            best[i] = bestSeconds;
+            mean[i] = sum / repeat;
+        }
+
+        std::printf("{\n  \"replay\": {\"journal\": \"%s\", \"records\": %lld, \"repeat\": %d, "
+                    "\"hardware_threads\": %u},\n",
+                    path, records, repeat, std::thread::hardware_concurrency());
+        std::printf("  \"runs\": [");
+        for (size_t i = 0; i < workerCounts.size(); ++i)
+        {
+            std::printf("%s\n    {\"workers\": %d, \"best_seconds\": %.6f, \"mean_seconds\": %.6f, "
+                        "\"records_per_sec\": %.1f, \"speedup\": %.3f}",
+                        i ? "," : "", workerCounts[i], best[i], mean[i],
+                        best[i] > 0 ? static_cast<double>(records) / best[i] : 0.0,
+                        best[i] > 0 ? best[0] / best[i] : 0.0);
+        }
+        std::printf("\n  ]\n}\n");
+        return 0;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    workloadconfig cfg;
+    bool dump = false;
+    bool replay = false;
+    std::string journalPath;
+    std::vector<int> workerCounts{1, 2, 4, 8, 16};
+    int repeat = 3;
+    // --worst-case 先生效，其余参数在其基础上覆盖
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string_view(argv[i]) == "--worst-case")
+            cfg = workloadconfig::worst_case();
+    }
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg(argv[i]);
+        std::string_view v;
+        if (arg == "--worst-case")
+            continue;
+        if (arg == "--dump")
+            dump = true;
+        else if (arg == "--replay")
+            replay = true;
+        else if (parseOption(arg, "journal", v))
+            journalPath = std::string(v);
+        else if (parseOption(arg, "workers", v))
+            workerCounts = parseList(v);
+        else if (parseOption(arg, "repeat", v))
+            repeat = std::atoi(v.data());
+        else if (parseOption(arg, "teams", v))
+            cfg.teams = std::atoi(v.data());
+        else if (parseOption(arg, "problems", v))
+            cfg.problems = std::atoi(v.data());
+        else if (parseOption(arg, "duration", v))
+            cfg.duration = std::atoi(v.data());
+        else if (parseOption(arg, "ops", v))
+            cfg.ops = std::atoi(v.data());
+        else if (parseOption(arg, "seed", v))
+            cfg.seed = std::strtoull(v.data(), nullptr, 10);
+        else if (parseOption(arg, "flush", v))
+            cfg.flush_ratio = std::atof(v.data());
+        else if (parseOption(arg, "freeze", v))
+            cfg.freeze_ratio = std::atof(v.data());
+        else if (parseOption(arg, "scroll", v))
+            cfg.scroll_ratio = std::atof(v.data());
+        else if (parseOption(arg, "query", v))
+            cfg.query_ratio = std::atof(v.data());
+        else if (parseOption(arg, "ac", v))
+            cfg.ac_ratio = std::atof(v.data());
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (workerCounts.empty() || repeat <= 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (replay && !journalPath.empty())
+    {
+        int devnull = ::open("/dev/null", O_WRONLY);
+        if (devnull < 0)
+        {
+            std::perror("/dev/null");
+            return 1;
+        }
+        int rc = runReplay(journalPath.c_str(), workerCounts, repeat, devnull);
+        ::close(devnull);
+        return rc;
+    }
+
+    std::vector<command> cmds = workloadgen(cfg).generate();
+    if (dump)
+    {
+        outputbuffer out;
+        for (const command &c: cmds)
+            out << c.line << '\n';
+        return 0;
+    }
+
+    int devnull = ::open("/dev/null", O_WRONLY);
+    if (devnull < 0)
+    {
+        std::perror("/dev/null");
+        return 1;
+    }
+
+    if (replay)
+    {
+        std::string path = writeJournal(cmds, devnull);
+        if (path.empty())
+        {
+            std::perror("cannot write journal");
+            ::close(devnull);
+            return 1;
+        }
+        std::vector<command>().swap(cmds);
+        int rc = runReplay(path.c_str(), workerCounts, repeat, devnull);
+        ::unlink(path.c_str());
+        ::close(devnull);
+        return rc;
+    }
+
+    constexpr int KINDS = static_cast<int>(TokenType::UNKNOWN) + 1;
+    std::vector<std::vector<uint64_t>> samples(KINDS);
+    using clock = std::chrono::steady_clock;
+    uint64_t totalNs = 0;
+    {
+        parser p;
+        p.set_output_fd(devnull);
+        for (const command &c: cmds)
+        {
+            auto t0 = clock::now();
+            p.execute(c.line);
+            auto t1 = clock::now();
+            uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+            samples[static_cast<int>(c.type)].push_back(ns);
+            totalNs += ns;
+        }
+    } // parser 析构时写出剩余输出，不计入命令耗时
+    ::close(devnull);
+
+    std::printf("{\n  \"config\": {\"teams\": %d, \"problems\": %d, \"duration\": %d, \"ops\": %d, \"seed\": %llu, "
+                "\"flush\": %g, \"freeze\": %g, \"scroll\": %g, \"query\": %g, \"ac\": %g},\n",
+                cfg.teams, cfg.problems, cfg.duration, cfg.ops, static_cast<unsigned long long>(cfg.seed),
+                cfg.flush_ratio, cfg.freeze_ratio, cfg.scroll_ratio, cfg.query_ratio, cfg.ac_ratio);
+    std::printf("  \"total\": {\"commands\": %zu, \"seconds\": %.6f, \"ops_per_sec\": %.1f},\n", cmds.size(),
+                static_cast<double>(totalNs) / 1e9,
+                totalNs ? static_cast<double>(cmds.size()) * 1e9 / static_cast<double>(totalNs) : 0.0);
+    std::printf("  \"commands\": {");
+    bool first = true;
+    for (int k = 0; k < KINDS; ++k)
+    {
+        std::vector<uint64_t> &s = samples[k];
+        if (s.empty())
+            continue;
+        std::sort(s.begin(), s.end());
+        uint64_t sum = 0;
+        for (uint64_t v: s)
+            sum += v;
+        std::printf("%s\n    \"%s\": {\"count\": %zu, \"seconds\": %.6f, \"ops_per_sec\": %.1f, \"mean_ns\": %.1f, "
+                    "\"p50_ns\": %llu, \"p90_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu}",
+                    first ? "" : ",", commandName(static_cast<TokenType>(k)), s.size(),
+                    static_cast<double>(sum) / 1e9,
+                    sum ? static_cast<double>(s.size()) * 1e9 / static_cast<double>(sum) : 0.0,
+                    static_cast<double>(sum) / static_cast<double>(s.size()),
+                    static_cast<unsigned long long>(percentile(s, 0.50)),
+                    static_cast<unsigned long long>(percentile(s, 0.90)),
+                    static_cast<unsigned long long>(percentile(s, 0.99)),
+                    static_cast<unsigned long long>(percentile(s, 0.999)),
+                    static_cast<unsigned long long>(s.back()));
+        first = false;
+    }
+    std::printf("\n  }\n}\n");
+    return 0;
+}
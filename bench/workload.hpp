@@ -0,0 +1,182 @@
+#pragma once
+#ifndef WORKLOAD_HPP
+#define WORKLOAD_HPP
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/rankingkey.hpp"
+#include "../include/token.hpp"
+
+/**
+ * 负载参数
+ * 各 *_ratio 为每条操作取到对应命令的概率，其余操作均为 SUBMIT
+ */
+struct workloadconfig
+{
+    int teams = 1000; // 队伍数 N
+    int problems = 26; // 题目数 M
+    int duration = 100000; // 比赛时长
+    int ops = 100000; // START 之后、END 之前的操作数
+    uint64_t seed = 1;
+
+    double flush_ratio = 0.003;
+    double freeze_ratio = 0.0001; // 未封榜时发起封榜的概率
+    double scroll_ratio = 0.0005; // 已封榜时发起滚榜的概率
+    double query_ratio = 0.2; // QUERY_RANKING / QUERY_SUBMISSION / QUERY_LIVE_RANKING
+    double ac_ratio = 0.3; // SUBMIT 中 Accepted 的比例
+
+    int max_flush = 1000; // 题面上限：刷新榜单不超过 1000 次
+    int max_freeze = 10; // 题面上限：封榜不超过 10 次
+
+    /// 题面的最坏规模：N = 10^4，M = 26，3×10^5 条操作，刷满 1000 次 FLUSH 与 10 次封榜 / 滚榜
+    static workloadconfig worst_case()
+    {
+        workloadconfig c;
+        c.teams = 10000;
+        c.problems = MAX_PROBLEMS;
+        c.duration = 100000;
+        c.ops = 300000;
+        c.flush_ratio = 1000.0 / 300000 * 1.1;
+        c.freeze_ratio = 10.0 / 300000 * 2;
+        c.scroll_ratio = 10.0 / 300000 * 4;
+        return c;
+    }
+};
+
+/// 生成出的一条命令，type 为其命令关键字
+struct command
+{
+    TokenType type;
+    std::string line;
+};
+
+/**
+ * workloadgen 类
+ * 按 workloadconfig 生成符合题面约束的命令序列：队名不重复，提交时间单调不降，
+ * FLUSH 与封榜次数不超过上限，封榜后必定滚榜，END 时不处于封榜状态
+ * 同一 seed 总是生成同一序列
+ */
+class workloadgen
+{
+private:
+    static constexpr const char *STATUS_NAMES[] = {"Accepted", "Wrong_Answer", "Runtime_Error",
+                                                   "Time_Limit_Exceed"};
+
+    workloadconfig cfg;
+    std::mt19937_64 rng;
+    std::vector<std::string> names;
+
+    double uniform() { return std::uniform_real_distribution<double>(0.0, 1.0)(rng); }
+    int pick(int n) { return static_cast<int>(rng() % static_cast<uint64_t>(n)); }
+
+    /// 随机字母数字前缀 + 下划线 + 36 进制序号，保证不重复且不超过 20 个字符
+    std::string make_name(int i)
+    {
+        static constexpr char ALNUM[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+        std::string s;
+        int len = 3 + pick(8);
+        for (int k = 0; k < len; ++k)
+            s.push_back(ALNUM[pick(62)]);
+        s.push_back('_');
+        std::string id;
+        do
+        {
+            id.push_back("0123456789abcdefghijklmnopqrstuvwxyz"[i % 36]);
+            i /= 36;
+        }
+        while (i > 0);
+        s.append(id.rbegin(), id.rend());
+        return s;
+    }
+
+    std::string random_problem() { return std::string(1, static_cast<char>('A' + pick(cfg.problems))); }
+
+    command make_query()
+    {
+        const std::string &name = names[pick(cfg.teams)];
+        double r = uniform();
+        if (r < 0.45)
+            return {TokenType::QUERY_RANKING, "QUERY_RANKING " + name};
+        if (r < 0.55)
+            return {TokenType::QUERY_LIVE_RANKING, "QUERY_LIVE_RANKING " + name};
+        std::string problem = pick(2) ? std::string("ALL") : random_problem();
+        std::string status = pick(2) ? std::string("ALL") : std::string(STATUS_NAMES[pick(4)]);
+        return {TokenType::QUERY_SUBMISSION,
+                "QUERY_SUBMISSION " + name + " WHERE PROBLEM=" + problem + " AND STATUS=" + status};
+    }
+
+public:
+    explicit workloadgen(const workloadconfig &c) : cfg(c), rng(c.seed)
+    {
+        cfg.teams = std::max(cfg.teams, 1);
+        cfg.problems = std::clamp(cfg.problems, 1, MAX_PROBLEMS);
+        cfg.duration = std::max(cfg.duration, 1);
+        cfg.ops = std::max(cfg.ops, 0);
+    }
+
+    std::vector<command> generate()
+    {
+        std::vector<command> cmds;
+        cmds.reserve(static_cast<size_t>(cfg.teams) + static_cast<size_t>(cfg.ops) + 12);
+
+        names.clear();
+        for (int i = 0; i < cfg.teams; ++i)
+        {
+            names.push_back(make_name(i));
+            cmds.push_back({TokenType::ADDTEAM, "ADDTEAM " + names.back()});
+        }
+        cmds.push_back({TokenType::START, "START DURATION " + std::to_string(cfg.duration) + " PROBLEM " +
+                                                  std::to_string(cfg.problems)});
+
+        int flushes = 0;
+        int freezes = 0;
+        bool frozen = false;
+        double now = 1.0;
+        double step = static_cast<double>(cfg.duration - 1) / std::max(cfg.ops, 1);
+        for (int op = 0; op < cfg.ops; ++op)
+        {
+            double r = uniform();
+            if (r < cfg.flush_ratio && flushes < cfg.max_flush)
+            {
+                flushes++;
+                cmds.push_back({TokenType::FLUSH, "FLUSH"});
+                continue;
+            }
+            r -= cfg.flush_ratio;
+            if (!frozen && r < cfg.freeze_ratio && freezes < cfg.max_freeze)
+            {
+                freezes++;
+                frozen = true;
+                cmds.push_back({TokenType::FREEZE, "FREEZE"});
+                continue;
+            }
+            if (frozen && r < cfg.scroll_ratio)
+            {
+                frozen = false;
+                cmds.push_back({TokenType::SCROLL, "SCROLL"});
+                continue;
+            }
+            r -= std::max(cfg.freeze_ratio, cfg.scroll_ratio);
+            if (r < cfg.query_ratio)
+            {
+                cmds.push_back(make_query());
+                continue;
+            }
+
+            // 时间按操作序号均匀推进，保证单调不降且不超过比赛时长
+            now += step;
+            int t = std::min(static_cast<int>(now), cfg.duration);
+            const char *status = uniform() < cfg.ac_ratio ? STATUS_NAMES[0] : STATUS_NAMES[1 + pick(3)];
+            cmds.push_back({TokenType::SUBMIT, "SUBMIT " + random_problem() + " BY " + names[pick(cfg.teams)] +
+                                                       " WITH " + status + " AT " + std::to_string(t)});
+        }
+        if (frozen)
+            cmds.push_back({TokenType::SCROLL, "SCROLL"}); // END 时不得处于封榜状态
+        cmds.push_back({TokenType::END, "END"});
+        return cmds;
+    }
+};
+
+#endif // WORKLOAD_HPP
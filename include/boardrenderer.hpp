@@ -0,0 +1,92 @@
+#pragma once
+#ifndef BOARDRENDERER_HPP
+#define BOARDRENDERER_HPP
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "output.hpp"
+#include "ranking.hpp"
+#include "team.hpp"
+
+/**
+ * boardrenderer 类
+ * 滚榜时输出整张榜单：每行为 队名 名次 通过数 罚时 各题状态
+ * 各队的题目状态文本缓存起来，只有被标记为脏的队伍才重新格式化；
+ * 整行用 to_chars 直接写进输出缓冲，不逐字段经过 operator<<。
+ */
+class boardrenderer
+{
+private:
+    std::vector<std::string> cells; // 队伍编号 → 缓存的题目状态文本（每格后跟一个空格）
+    std::vector<char> dirty; // 队伍编号 → 缓存是否失效
+
+    static constexpr size_t INT_CHARS = 11; // int 的最大十进制长度（含负号）
+
+    /// 取得队伍 id 的题目状态文本，缓存失效时重新格式化
+    const std::string &cells_of(const team &t, int id, int problem_count)
+    {
+        if (dirty[id])
+        {
+            char tmp[MAX_PROBLEMS * (MAX_CELL_CHARS + 1)];
+            char *p = tmp;
+            const auto &statuses = t.get_submit_status();
+            for (int i = 0; i < problem_count; ++i)
+            {
+                p = statuses[i].format(p);
+                *p++ = ' ';
+            }
+            cells[id].assign(tmp, p);
+            dirty[id] = 0;
+        }
+        return cells[id];
+    }
+
+public:
+    /// 队伍 id 的题目状态发生了变化
+    void invalidate(int id)
+    {
+        if (static_cast<size_t>(id) < dirty.size())
+            dirty[id] = 1;
+    }
+
+    /// 按 order 的顺序输出 teams 的整张榜单
+    void render(outputbuffer &out, const std::vector<team> &teams, const rankingindex &order, int problem_count)
+    {
+        if (cells.size() < teams.size())
+        {
+            cells.resize(teams.size());
+            dirty.resize(teams.size(), 1);
+        }
+        for (int id: order)
+        {
+            const team &t = teams[id];
+            const std::string &name = t.get_name();
+            const std::string &row = cells_of(t, id, problem_count);
+            size_t need = name.size() + row.size() + 3 * (INT_CHARS + 1) + 2;
+            if (need > outputbuffer::max_claim())
+            {
+                out << name << " " << t.get_rank() << " " << t.get_solved_count() << " " << t.get_time_punishment()
+                    << " " << row << "\n";
+                continue;
+            }
+            char *start = out.claim(need);
+            char *p = start;
+            std::memcpy(p, name.data(), name.size());
+            p += name.size();
+            *p++ = ' ';
+            p = std::to_chars(p, p + INT_CHARS, t.get_rank()).ptr;
+            *p++ = ' ';
+            p = std::to_chars(p, p + INT_CHARS, t.get_solved_count()).ptr;
+            *p++ = ' ';
+            p = std::to_chars(p, p + INT_CHARS, t.get_time_punishment()).ptr;
+            *p++ = ' ';
+            std::memcpy(p, row.data(), row.size());
+            p += row.size();
+            *p++ = '\n';
+            out.advance(static_cast<size_t>(p - start));
+        }
+    }
+};
+
+#endif // BOARDRENDERER_HPP
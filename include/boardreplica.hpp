@@ -0,0 +1,124 @@
+#pragma once
+#ifndef BOARDREPLICA_HPP
+#define BOARDREPLICA_HPP
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "boardsnapshot.hpp"
+#include "output.hpp"
+#include "parser.hpp"
+#include "token.hpp"
+
+/**
+ * boardreplica 类
+ * 只读副本：在写入方发布的共享内存榜单快照上回答 QUERY_RANKING 与 QUERY_BOARD，
+ * 输出与写入方在最近一次 FLUSH 之后执行同一查询时相同；其他命令一律拒绝。
+ * 每次查询只在顺序锁下拷出所需的几个字段，不与写入方竞争任何锁。
+ */
+class boardreplica
+{
+private:
+    boardreader snapshot;
+    outputbuffer out;
+    std::vector<boardformat::boardentry> slice; // QUERY_BOARD 拷出的行
+
+public:
+    /// 映射写入方的共享段 path
+    bool open(const char *path) { return snapshot.open(path); }
+
+    void set_flush_policy(FlushPolicy policy) { out.set_policy(policy); }
+
+    /// 执行一条查询
+    void execute(std::string_view cmd)
+    {
+        tokenstream ts = parser::tokenize(cmd);
+        token *keyToken = ts.get();
+        if (!keyToken)
+            return; // 空白行
+
+        switch (keyToken->type)
+        {
+            /// QUERY_RANKING teamName：上次 FLUSH 的名次（副本不记录排名历史，不支持 AT）
+            case TokenType::QUERY_RANKING: {
+                token *nameToken = ts.get();
+                std::string_view teamName = nameToken->value;
+                token *atToken = ts.get();
+                int teamId = -1;
+                int rank = 0;
+                bool frozen = false;
+                snapshot.read([&] {
+                    teamId = snapshot.find(teamName);
+                    rank = teamId >= 0 ? snapshot.rank(teamId) : 0;
+                    frozen = snapshot.frozen();
+                });
+                if (atToken && atToken->value == "AT")
+                {
+                    out << (teamId < 0 ? "[Error]Query ranking failed: cannot find the team.\n"
+                                       : "[Error]Query ranking failed: history mode is off.\n");
+                    break;
+                }
+                if (teamId < 0)
+                {
+                    out << "[Error]Query ranking failed: cannot find the team.\n";
+                    break;
+                }
+                out << "[Info]Complete query ranking.\n";
+                if (frozen)
+                    out << "[Warning]Scoreboard is frozen. The ranking may be inaccurate until it were scrolled.\n";
+                out << teamName << " NOW AT RANKING " << rank << "\n";
+                break;
+            }
+
+            /// QUERY_BOARD [from] [count]：上次 FLUSH 的榜单中名次 from 起的 count 行
+            case TokenType::QUERY_BOARD: {
+                token *fromToken = ts.get();
+                token *countToken = ts.get();
+                int from = fromToken ? parser::parse_int(fromToken->value) : 1;
+                int count = countToken ? parser::parse_int(countToken->value) : 0;
+                bool valid = false;
+                size_t size = 0;
+                bool frozen = false;
+                snapshot.read([&] {
+                    size = snapshot.rows();
+                    frozen = snapshot.frozen();
+                    slice.clear();
+                    valid = from >= 1 && static_cast<size_t>(from) <= size && count >= 0;
+                    if (!valid)
+                        return;
+                    size_t begin = static_cast<size_t>(from) - 1;
+                    size_t rows = countToken ? static_cast<size_t>(count) : size;
+                    size_t end = begin + std::min(rows, size - begin);
+                    for (size_t pos = begin; pos < end; ++pos)
+                        slice.push_back(snapshot.row(pos));
+                });
+                if (!valid)
+                {
+                    out << "[Error]Query board failed: rank out of range.\n";
+                    break;
+                }
+                out << "[Info]Complete query board.\n";
+                if (frozen)
+                    out << "[Warning]Scoreboard is frozen. The ranking may be inaccurate until it were scrolled.\n";
+                for (size_t i = 0; i < slice.size(); ++i)
+                {
+                    const boardformat::boardentry &row = slice[i];
+                    out << snapshot.name(static_cast<int>(row.id)) << " " << from + i << " " << row.solved << " "
+                        << row.penalty << "\n";
+                }
+                break;
+            }
+
+            case TokenType::END:
+                out.flush();
+                break;
+
+            default:
+                out << "[Error]Command failed: read-only replica.\n";
+                break;
+        }
+        out.commit();
+    }
+};
+
+#endif // BOARDREPLICA_HPP
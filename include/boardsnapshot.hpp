@@ -0,0 +1,426 @@
+#pragma once
+#ifndef BOARDSNAPSHOT_HPP
+#define BOARDSNAPSHOT_HPP
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "team.hpp"
+#include "teamindex.hpp"
+
+/**
+ * 共享内存榜单快照的布局
+ * 写入方（执行命令的进程）每次 FLUSH 后把榜单发布到一个 MAP_SHARED 映射的文件（通常位于 /dev/shm），
+ * 只读副本进程映射同一文件回答查询。整个段由一个顺序锁保护：写入方改动前把 seq 加一成奇数，改完再加一；
+ * 读取方先取 seq（为偶数），拷出所需数据后再取一次，两次相同才采用，否则重读。写入方从不等待读取方。
+ *
+ * 段由定长的 boardheader 与四节组成，各节起点按 8 字节对齐：
+ *   队名：uint32 偏移数组（teams + 1 项）后接全部队名，只在布局改变时写入
+ *   榜单：上次 FLUSH 的各行 boardentry，下标为名次 - 1，共 rows 行
+ *   名次：队伍编号 → 上次 FLUSH 的名次
+ *   题目格：队伍编号 → 各题的显示文本，每题占 CELL_BYTES 字节（1 字节长度后接文本），每队占 cell_stride 字节
+ * 队伍数或题目数变化时重新布局，generation 随之加一，读取方据此重新映射并重建队名表。
+ */
+namespace boardformat
+{
+    constexpr char MAGIC[8] = {'I', 'C', 'P', 'C', 'B', 'R', 'D', '1'};
+    constexpr size_t CELL_BYTES = MAX_CELL_CHARS + 1;
+
+    /// 布局：队伍数、题目数与各节的位置，只在重新布局时改变
+    struct boardlayout
+    {
+        uint64_t generation; // 布局编号，0 表示尚未发布
+        uint64_t bytes; // 用到的总字节数
+        uint32_t teams;
+        uint32_t problems;
+        uint64_t names_offset;
+        uint64_t rows_offset;
+        uint64_t ranks_offset;
+        uint64_t cells_offset;
+        uint64_t cell_stride;
+    };
+
+    struct boardheader
+    {
+        char magic[8];
+        std::atomic<uint64_t> seq; // 奇数表示正在写
+        uint32_t rows; // 榜单行数
+        uint32_t frozen;
+        boardlayout layout;
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "顺序锁计数须为无锁原子量才能跨进程共享");
+
+    /// 榜单的一行
+    struct boardentry
+    {
+        uint32_t id;
+        int32_t solved;
+        int32_t penalty;
+    };
+
+    inline uint64_t align8(uint64_t x) { return (x + 7) & ~uint64_t(7); }
+} // namespace boardformat
+
+/**
+ * boardpublisher 类
+ * 写入方：维护共享段的映射与布局，发布过程须包在 begin / end 之间
+ * 题目格只重写 invalidate 过的 (队伍, 题目)，名次与榜单行只重写本次 FLUSH 变化的区间
+ */
+class boardpublisher
+{
+private:
+    int fd = -1;
+    char *base = nullptr;
+    size_t mapped = 0;
+    bool laidOut = false; // 打开后尚未布局时，第一次发布须整体写入
+    std::vector<uint32_t> stale; // 队伍编号 → 待重写的题目位图
+    std::vector<uint32_t> staleList; // 待重写的题目格：队伍编号 * MAX_PROBLEMS + 题号
+    bool rewriteAll = false; // 刚重新布局，全部题目格待重写
+    boardformat::boardlayout current{}; // 当前布局（reserve 之后为即将由 layout 写入的新布局）
+
+    boardformat::boardheader *head() const { return reinterpret_cast<boardformat::boardheader *>(base); }
+
+    bool map(size_t size)
+    {
+        if (base)
+            ::munmap(base, mapped);
+        void *addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        base = addr == MAP_FAILED ? nullptr : static_cast<char *>(addr);
+        mapped = base ? size : 0;
+        return base != nullptr;
+    }
+
+public:
+    boardpublisher() = default;
+    boardpublisher(const boardpublisher &) = delete;
+    boardpublisher &operator=(const boardpublisher &) = delete;
+    ~boardpublisher() { close(); }
+
+    void close()
+    {
+        if (base)
+            ::munmap(base, mapped);
+        if (fd >= 0)
+            ::close(fd);
+        base = nullptr;
+        mapped = 0;
+        fd = -1;
+    }
+
+    /**
+     * 打开（必要时创建）共享段；已有同格式的段时沿用其 seq 与 generation，已映射该段的读取方无需重启
+     * 其他内容的文件被重置为空段
+     */
+    bool open(const char *path)
+    {
+        fd = ::open(path, O_RDWR | O_CREAT, 0644);
+        struct stat st;
+        if (fd < 0 || ::fstat(fd, &st) != 0)
+        {
+            close();
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        bool reuse = size >= sizeof(boardformat::boardheader);
+        if ((!reuse && ::ftruncate(fd, sizeof(boardformat::boardheader)) != 0) ||
+            !map(reuse ? size : sizeof(boardformat::boardheader)))
+        {
+            close();
+            return false;
+        }
+        boardformat::boardheader *h = head();
+        if (!reuse || std::memcmp(h->magic, boardformat::MAGIC, sizeof(boardformat::MAGIC)) != 0)
+        {
+            std::memcpy(h->magic, boardformat::MAGIC, sizeof(boardformat::MAGIC));
+            h->seq.store(0, std::memory_order_relaxed);
+            h->rows = 0;
+            h->frozen = 0;
+            h->layout = boardformat::boardlayout{};
+        }
+        uint64_t s = h->seq.load(std::memory_order_relaxed);
+        if (s & 1)
+            h->seq.store(s + 1, std::memory_order_release); // 上一个写入方中途退出
+        return true;
+    }
+
+    bool is_open() const { return base != nullptr; }
+
+    /// 队伍 id 第 problem 题的显示文本变了，下次发布时重写
+    void invalidate(int id, int problem)
+    {
+        if (static_cast<size_t>(id) >= stale.size())
+            stale.resize(static_cast<size_t>(id) + 1, 0);
+        uint32_t bit = uint32_t(1) << problem;
+        if (!(stale[id] & bit))
+        {
+            stale[id] |= bit;
+            staleList.push_back(static_cast<uint32_t>(id) * MAX_PROBLEMS + static_cast<uint32_t>(problem));
+        }
+    }
+
+    /// 开始一次发布：此后直到 end，读取方的读取都会重试
+    void begin()
+    {
+        boardformat::boardheader *h = head();
+        h->seq.store(h->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void end()
+    {
+        boardformat::boardheader *h = head();
+        h->seq.store(h->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// 队伍数或题目数与当前布局不同（或尚未布局）
+    bool needs_layout(size_t teamCount, int problemCount) const
+    {
+        return !laidOut || teamCount != current.teams || static_cast<uint32_t>(problemCount) != current.problems;
+    }
+
+    /**
+     * 重新布局的第一步，在 begin 之前调用：按新布局的大小扩大文件与映射，不改动已发布的内容
+     * 失败（如共享内存空间不足）时关闭共享段，之后不再发布
+     */
+    template<class NameOf>
+    bool reserve(size_t teamCount, int problemCount, NameOf nameOf)
+    {
+        current = boardformat::boardlayout{};
+        uint64_t nameBytes = 0;
+        for (size_t id = 0; id < teamCount; ++id)
+            nameBytes += nameOf(static_cast<int>(id)).size();
+        current.teams = static_cast<uint32_t>(teamCount);
+        current.problems = static_cast<uint32_t>(problemCount);
+        current.cell_stride = boardformat::align8(static_cast<uint64_t>(problemCount) * boardformat::CELL_BYTES);
+        current.names_offset = boardformat::align8(sizeof(boardformat::boardheader));
+        current.rows_offset = boardformat::align8(current.names_offset + 4 * (teamCount + 1) + nameBytes);
+        current.ranks_offset = boardformat::align8(current.rows_offset + sizeof(boardformat::boardentry) * teamCount);
+        current.cells_offset = boardformat::align8(current.ranks_offset + 4 * teamCount);
+        current.bytes = current.cells_offset + current.cell_stride * teamCount;
+        if (current.bytes <= mapped)
+            return true;
+        if (::ftruncate(fd, static_cast<off_t>(current.bytes)) == 0 && map(current.bytes))
+            return true;
+        close();
+        return false;
+    }
+
+    /**
+     * 重新布局的第二步，在 begin 之后调用：写入 reserve 算好的布局与全部队名，nameOf(id) 给出队名
+     * 之后调用方须写入全部名次与榜单行，并调用 write_cells 写入全部题目格
+     */
+    template<class NameOf>
+    void layout(NameOf nameOf)
+    {
+        boardformat::boardheader *h = head();
+        current.generation = h->layout.generation + 1;
+        h->layout = current;
+        h->rows = 0;
+
+        uint32_t *offsets = reinterpret_cast<uint32_t *>(base + current.names_offset);
+        char *pool = base + current.names_offset + 4 * (uint64_t(current.teams) + 1);
+        uint32_t at = 0;
+        offsets[0] = 0;
+        for (uint32_t id = 0; id < current.teams; ++id)
+        {
+            std::string_view name = nameOf(static_cast<int>(id));
+            std::memcpy(pool + at, name.data(), name.size());
+            at += static_cast<uint32_t>(name.size());
+            offsets[id + 1] = at;
+        }
+        laidOut = true;
+        rewriteAll = true;
+    }
+
+    void set_row(size_t pos, int id, int solved, int penalty)
+    {
+        reinterpret_cast<boardformat::boardentry *>(base + current.rows_offset)[pos] = {
+                static_cast<uint32_t>(id), solved, penalty};
+    }
+    void set_rank(int id, int rank) { reinterpret_cast<int32_t *>(base + current.ranks_offset)[id] = rank; }
+    void set_rows(size_t rows) { head()->rows = static_cast<uint32_t>(rows); }
+    void set_frozen(bool frozen) { head()->frozen = frozen ? 1 : 0; }
+
+    /// 重写 invalidate 过的题目格（刚重新布局时为全部题目格），teamOf(id) 给出队伍
+    template<class TeamOf>
+    void write_cells(TeamOf teamOf)
+    {
+        auto write = [&](uint32_t id, uint32_t problem) {
+            char *cell = base + current.cells_offset + current.cell_stride * id + boardformat::CELL_BYTES * problem;
+            const char *end = teamOf(static_cast<int>(id)).get_submit_status()[problem].format(cell + 1);
+            cell[0] = static_cast<char>(end - (cell + 1));
+        };
+        if (rewriteAll)
+        {
+            for (uint32_t id = 0; id < current.teams; ++id)
+            {
+                for (uint32_t problem = 0; problem < current.problems; ++problem)
+                    write(id, problem);
+            }
+        }
+        else
+        {
+            for (uint32_t key: staleList)
+            {
+                uint32_t id = key / MAX_PROBLEMS;
+                uint32_t problem = key % MAX_PROBLEMS;
+                if (id < current.teams && problem < current.problems)
+                    write(id, problem);
+            }
+        }
+        for (uint32_t key: staleList)
+            stale[key / MAX_PROBLEMS] = 0;
+        staleList.clear();
+        rewriteAll = false;
+    }
+};
+
+/**
+ * boardreader 类
+ * 读取方：只读映射共享段，read(f) 在一致的快照上执行 f（f 只应把数据拷出，可能被执行多次）
+ * 队名在每个布局内不变，映射时拷进本地的 teamindex，按队名查找不再访问共享段
+ */
+class boardreader
+{
+private:
+    static constexpr int SPINS = 64;
+
+    int fd = -1;
+    const char *base = nullptr;
+    size_t mapped = 0;
+    boardformat::boardlayout layout{}; // 已跟上的布局
+    teamindex names;
+
+    const boardformat::boardheader *head() const
+    {
+        return reinterpret_cast<const boardformat::boardheader *>(base);
+    }
+
+    bool map(size_t size)
+    {
+        if (base)
+            ::munmap(const_cast<char *>(base), mapped);
+        void *addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        base = addr == MAP_FAILED ? nullptr : static_cast<const char *>(addr);
+        mapped = base ? size : 0;
+        return base != nullptr;
+    }
+
+    /**
+     * 写入方换了布局：按新的大小重新映射并重建队名表，seq 为本轮读到的（偶数）值
+     * 读到的布局在 seq 校验通过后才采用；映射失败返回 false
+     */
+    bool attach(uint64_t seq)
+    {
+        boardformat::boardlayout next = head()->layout;
+        if (next.bytes > mapped && !map(next.bytes))
+            return false;
+        teamindex fresh;
+        uint64_t pool = next.names_offset + 4 * (uint64_t(next.teams) + 1);
+        if (next.bytes <= mapped && pool <= next.bytes)
+        {
+            const uint32_t *offsets = reinterpret_cast<const uint32_t *>(base + next.names_offset);
+            fresh.reserve(next.teams);
+            for (uint32_t id = 0; id < next.teams; ++id)
+            {
+                uint32_t from = offsets[id];
+                uint32_t to = offsets[id + 1];
+                if (from > to || pool + to > next.bytes)
+                    break; // 读到了正在改写的数据，下面的 seq 校验不会通过
+                fresh.intern(std::string_view(base + pool + from, to - from));
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (head()->seq.load(std::memory_order_relaxed) == seq && fresh.size() == next.teams)
+        {
+            names = std::move(fresh);
+            layout = next;
+        }
+        return true;
+    }
+
+public:
+    boardreader() = default;
+    boardreader(const boardreader &) = delete;
+    boardreader &operator=(const boardreader &) = delete;
+    ~boardreader()
+    {
+        if (base)
+            ::munmap(const_cast<char *>(base), mapped);
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    /// 映射写入方创建的共享段，文件不存在或不是榜单快照时返回 false
+    bool open(const char *path)
+    {
+        fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(boardformat::boardheader))
+            return false;
+        if (!map(static_cast<size_t>(st.st_size)))
+            return false;
+        return std::memcmp(head()->magic, boardformat::MAGIC, sizeof(boardformat::MAGIC)) == 0;
+    }
+
+    /**
+     * 在一致的快照上执行 f()，必要时先跟上写入方的新布局；映射失败时返回 false
+     * 写入方长时间处于写状态时先自旋再让出 CPU
+     */
+    template<class F>
+    bool read(F f)
+    {
+        for (int i = 0;; ++i)
+        {
+            if (i >= SPINS)
+                std::this_thread::yield();
+            uint64_t s = head()->seq.load(std::memory_order_acquire);
+            if (s & 1)
+                continue;
+            if (head()->layout.generation != layout.generation)
+            {
+                if (!attach(s))
+                    return false;
+                continue;
+            }
+            f();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (head()->seq.load(std::memory_order_relaxed) == s)
+                return true;
+        }
+    }
+
+    /// 以下访问须在 read 的回调中进行，所得编号与数据才属于同一快照
+    int find(std::string_view name) const { return names.find(name); }
+    std::string_view name(int id) const { return names.name(id); }
+    uint32_t rows() const { return std::min(head()->rows, layout.teams); }
+    bool frozen() const { return head()->frozen != 0; }
+    int rank(int id) const { return reinterpret_cast<const int32_t *>(base + layout.ranks_offset)[id]; }
+    boardformat::boardentry row(size_t pos) const
+    {
+        boardformat::boardentry e;
+        std::memcpy(&e, base + layout.rows_offset + pos * sizeof(e), sizeof(e));
+        e.id = std::min(e.id, layout.teams - 1); // 读到改写中的数据时不越界，seq 校验会使本次读取作废
+        return e;
+    }
+    uint32_t problems() const { return layout.problems; }
+    /// 队伍 id 第 problem 题的显示文本，指向共享段，须先拷出
+    std::string_view cell(int id, int problem) const
+    {
+        const char *c = base + layout.cells_offset + layout.cell_stride * static_cast<uint64_t>(id) +
+                        boardformat::CELL_BYTES * static_cast<uint64_t>(problem);
+        return std::string_view(c + 1, std::min<size_t>(static_cast<unsigned char>(c[0]), MAX_CELL_CHARS));
+    }
+};
+
+#endif // BOARDSNAPSHOT_HPP
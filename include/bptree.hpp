@@ -0,0 +1,628 @@
+#pragma once
+#ifndef BPTREE_HPP
+#define BPTREE_HPP
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "rankingkey.hpp"
+
+/**
+ * bptree 类
+ * 排名索引的 B+ 树实现：高扇出，叶子连续存放排名键与队伍编号并双向串联
+ * 叶子与内部结点各自放在结点池中，用 32 位下标互相引用。
+ * 内部结点第 i 个分隔键 sep[i] 满足：子树 i 中的键 < sep[i] <= 子树 i + 1 中的键；
+ * 删除只会让分隔键变"松"而不会破坏该性质，因此删除时无需改写祖先的分隔键。
+ * 内部结点同时记录每棵子树的条目数，rank 沿查找路径累加即可在 O(log N) 内求出实时名次。
+ * 同时记录自上次 clear_dirty 以来名次可能变化的位置区间，供增量刷新榜单使用。
+ */
+class bptree
+{
+private:
+    static constexpr int LEAF_CAP = 32; // 叶子最多容纳的条目数
+    static constexpr int INNER_CAP = 32; // 内部结点最多容纳的子结点数
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr size_t NPOS = SIZE_MAX;
+
+    struct leaf
+    {
+        int count = 0;
+        uint32_t prev = NONE;
+        uint32_t next = NONE;
+        rankingkey keys[LEAF_CAP];
+        int ids[LEAF_CAP];
+    };
+
+    struct inner
+    {
+        int count = 0; // 子结点个数，分隔键个数为 count - 1
+        rankingkey seps[INNER_CAP - 1];
+        uint32_t child[INNER_CAP];
+        uint32_t sizes[INNER_CAP]; // 各子树中的条目数
+    };
+
+    /// 自根向下的查找路径上的一步
+    struct step
+    {
+        uint32_t node;
+        int pos;
+    };
+
+    std::vector<leaf> leaves;
+    std::vector<inner> inners;
+    std::vector<uint32_t> free_leaves;
+    std::vector<uint32_t> free_inners;
+    uint32_t root = NONE;
+    int height = 0; // 0 表示根即为叶子
+    uint32_t head = NONE; // 最左叶子
+    uint32_t tail = NONE; // 最右叶子
+    size_t total = 0;
+    size_t dirty_lo = NPOS; // 名次可能变化的位置区间 [dirty_lo, dirty_hi)
+    size_t dirty_hi = 0;
+
+    uint32_t new_leaf()
+    {
+        if (!free_leaves.empty())
+        {
+            uint32_t x = free_leaves.back();
+            free_leaves.pop_back();
+            leaves[x].count = 0;
+            leaves[x].prev = leaves[x].next = NONE;
+            return x;
+        }
+        leaves.emplace_back();
+        return static_cast<uint32_t>(leaves.size() - 1);
+    }
+
+    uint32_t new_inner()
+    {
+        if (!free_inners.empty())
+        {
+            uint32_t x = free_inners.back();
+            free_inners.pop_back();
+            inners[x].count = 0;
+            return x;
+        }
+        inners.emplace_back();
+        return static_cast<uint32_t>(inners.size() - 1);
+    }
+
+    /// 内部结点中应当进入的子结点：分隔键中不大于 key 的个数
+    static int route(const inner &n, const rankingkey &key)
+    {
+        return static_cast<int>(std::upper_bound(n.seps, n.seps + n.count - 1, key) - n.seps);
+    }
+
+    /// 自根下降到 key 所在的叶子，path 记录经过的内部结点与子结点位置
+    uint32_t descend(const rankingkey &key, step *path) const
+    {
+        uint32_t x = root;
+        for (int level = height; level > 0; --level)
+        {
+            int pos = route(inners[x], key);
+            path[height - level] = {x, pos};
+            x = inners[x].child[pos];
+        }
+        return x;
+    }
+
+    void unlink_leaf(uint32_t x)
+    {
+        leaf &l = leaves[x];
+        if (l.prev != NONE)
+            leaves[l.prev].next = l.next;
+        else
+            head = l.next;
+        if (l.next != NONE)
+            leaves[l.next].prev = l.prev;
+        else
+            tail = l.prev;
+        free_leaves.push_back(x);
+    }
+
+    static uint32_t subtree_size(const inner &n)
+    {
+        uint32_t s = 0;
+        for (int i = 0; i < n.count; ++i)
+            s += n.sizes[i];
+        return s;
+    }
+
+    /**
+     * 在内部结点 p 的第 pos 个子结点之后插入分隔键 sep 与新子结点 c，必要时逐层分裂
+     * c 是从第 pos 个子结点中分裂出的右半部分，含 cSize 个条目
+     */
+    void insert_child(step *path, int depth, const rankingkey &sep, uint32_t c, uint32_t cSize)
+    {
+        rankingkey upKey = sep;
+        uint32_t upChild = c;
+        uint32_t upSize = cSize;
+        for (int d = depth; d >= 0; --d)
+        {
+            uint32_t p = path[d].node;
+            int pos = path[d].pos;
+            if (inners[p].count < INNER_CAP)
+            {
+                inner &n = inners[p];
+                std::copy_backward(n.seps + pos, n.seps + n.count - 1, n.seps + n.count);
+                std::copy_backward(n.child + pos + 1, n.child + n.count, n.child + n.count + 1);
+                std::copy_backward(n.sizes + pos + 1, n.sizes + n.count, n.sizes + n.count + 1);
+                n.seps[pos] = upKey;
+                n.child[pos + 1] = upChild;
+                n.sizes[pos] -= upSize;
+                n.sizes[pos + 1] = upSize;
+                n.count++;
+                return;
+            }
+
+            // 结点已满：先拼成 INNER_CAP + 1 个子结点，再对半分裂，中间的分隔键上移
+            rankingkey seps[INNER_CAP];
+            uint32_t child[INNER_CAP + 1];
+            uint32_t sizes[INNER_CAP + 1];
+            {
+                const inner &n = inners[p];
+                std::copy(n.seps, n.seps + pos, seps);
+                seps[pos] = upKey;
+                std::copy(n.seps + pos, n.seps + INNER_CAP - 1, seps + pos + 1);
+                std::copy(n.child, n.child + pos + 1, child);
+                child[pos + 1] = upChild;
+                std::copy(n.child + pos + 1, n.child + INNER_CAP, child + pos + 2);
+                std::copy(n.sizes, n.sizes + pos + 1, sizes);
+                sizes[pos] -= upSize;
+                sizes[pos + 1] = upSize;
+                std::copy(n.sizes + pos + 1, n.sizes + INNER_CAP, sizes + pos + 2);
+            }
+            uint32_t q = new_inner();
+            inner &left = inners[p];
+            inner &right = inners[q];
+            int half = (INNER_CAP + 1) / 2;
+            left.count = half;
+            std::copy(child, child + half, left.child);
+            std::copy(sizes, sizes + half, left.sizes);
+            std::copy(seps, seps + half - 1, left.seps);
+            right.count = INNER_CAP + 1 - half;
+            std::copy(child + half, child + INNER_CAP + 1, right.child);
+            std::copy(sizes + half, sizes + INNER_CAP + 1, right.sizes);
+            std::copy(seps + half, seps + INNER_CAP, right.seps);
+            upKey = seps[half - 1];
+            upChild = q;
+            upSize = subtree_size(right);
+        }
+
+        // 根结点分裂：树长高一层
+        uint32_t r = new_inner();
+        inner &n = inners[r];
+        n.count = 2;
+        n.child[0] = root;
+        n.child[1] = upChild;
+        n.sizes[0] = static_cast<uint32_t>(total) - upSize;
+        n.sizes[1] = upSize;
+        n.seps[0] = upKey;
+        root = r;
+        height++;
+    }
+
+    /// 从内部结点 p 中删去第 pos 个子结点（连同与之相邻的一个分隔键）
+    static void remove_child(inner &n, int pos)
+    {
+        int sepPos = pos > 0 ? pos - 1 : 0;
+        if (n.count > 1)
+            std::copy(n.seps + sepPos + 1, n.seps + n.count - 1, n.seps + sepPos);
+        std::copy(n.child + pos + 1, n.child + n.count, n.child + pos);
+        std::copy(n.sizes + pos + 1, n.sizes + n.count, n.sizes + pos);
+        n.count--;
+    }
+
+    /// 查找路径左侧各子树的条目数之和加上叶内位置，即该位置的全局序号
+    size_t offset(const step *path, int leafPos) const
+    {
+        size_t r = static_cast<size_t>(leafPos);
+        for (int d = 0; d < height; ++d)
+        {
+            const inner &n = inners[path[d].node];
+            for (int i = 0; i < path[d].pos; ++i)
+                r += n.sizes[i];
+        }
+        return r;
+    }
+
+    void mark_dirty(size_t lo, size_t hi)
+    {
+        if (lo >= hi)
+            return;
+        dirty_lo = std::min(dirty_lo, lo);
+        dirty_hi = std::max(dirty_hi, hi);
+    }
+
+    /// 插入条目并返回其位置
+    size_t insert_at(const rankingkey &key, int id)
+    {
+        if (root == NONE)
+        {
+            root = head = tail = new_leaf();
+            height = 0;
+        }
+        step path[64];
+        uint32_t x = descend(key, path);
+        int pos = static_cast<int>(std::lower_bound(leaves[x].keys, leaves[x].keys + leaves[x].count, key) -
+                                   leaves[x].keys);
+        size_t at = offset(path, pos);
+        total++;
+        for (int d = 0; d < height; ++d)
+            inners[path[d].node].sizes[path[d].pos]++;
+        if (leaves[x].count < LEAF_CAP)
+        {
+            leaf &l = leaves[x];
+            std::copy_backward(l.keys + pos, l.keys + l.count, l.keys + l.count + 1);
+            std::copy_backward(l.ids + pos, l.ids + l.count, l.ids + l.count + 1);
+            l.keys[pos] = key;
+            l.ids[pos] = id;
+            l.count++;
+            return at;
+        }
+
+        // 叶子已满：对半分裂，新叶子接在右侧
+        uint32_t y = new_leaf();
+        leaf &l = leaves[x];
+        leaf &r = leaves[y];
+        int half = LEAF_CAP / 2;
+        r.count = LEAF_CAP - half;
+        std::copy(l.keys + half, l.keys + LEAF_CAP, r.keys);
+        std::copy(l.ids + half, l.ids + LEAF_CAP, r.ids);
+        l.count = half;
+        r.prev = x;
+        r.next = l.next;
+        if (l.next != NONE)
+            leaves[l.next].prev = y;
+        else
+            tail = y;
+        l.next = y;
+
+        leaf &target = (pos <= half) ? l : r;
+        int tpos = (pos <= half) ? pos : pos - half;
+        std::copy_backward(target.keys + tpos, target.keys + target.count, target.keys + target.count + 1);
+        std::copy_backward(target.ids + tpos, target.ids + target.count, target.ids + target.count + 1);
+        target.keys[tpos] = key;
+        target.ids[tpos] = id;
+        target.count++;
+
+        if (height == 0)
+        {
+            uint32_t rt = new_inner();
+            inner &n = inners[rt];
+            n.count = 2;
+            n.child[0] = x;
+            n.child[1] = y;
+            n.sizes[0] = static_cast<uint32_t>(leaves[x].count);
+            n.sizes[1] = static_cast<uint32_t>(leaves[y].count);
+            n.seps[0] = leaves[y].keys[0];
+            root = rt;
+            height = 1;
+            return at;
+        }
+        insert_child(path, height - 1, leaves[y].keys[0], y, static_cast<uint32_t>(leaves[y].count));
+        return at;
+    }
+
+    /// 删除排名键为 key 的条目并返回其原位置，不存在返回 NPOS
+    size_t erase_at(const rankingkey &key)
+    {
+        if (root == NONE)
+            return NPOS;
+        step path[64];
+        uint32_t x = descend(key, path);
+        leaf &l = leaves[x];
+        int pos = static_cast<int>(std::lower_bound(l.keys, l.keys + l.count, key) - l.keys);
+        if (pos == l.count || l.keys[pos] != key)
+            return NPOS;
+        size_t at = offset(path, pos);
+        std::copy(l.keys + pos + 1, l.keys + l.count, l.keys + pos);
+        std::copy(l.ids + pos + 1, l.ids + l.count, l.ids + pos);
+        l.count--;
+        total--;
+        for (int d = 0; d < height; ++d)
+            inners[path[d].node].sizes[path[d].pos]--;
+
+        if (height == 0)
+        {
+            if (l.count == 0)
+                clear();
+            return at;
+        }
+
+        // 叶子过空时与同一父结点下的相邻叶子合并（合并后不超过 3/4 容量）
+        int depth = height - 1;
+        inner *parent = &inners[path[depth].node];
+        int cpos = path[depth].pos;
+        bool removed = false;
+        if (l.count == 0)
+        {
+            unlink_leaf(x);
+            remove_child(*parent, cpos);
+            removed = true;
+        }
+        else if (l.count < LEAF_CAP / 4 && parent->count > 1)
+        {
+            int lpos = cpos > 0 ? cpos - 1 : cpos;
+            uint32_t a = parent->child[lpos];
+            uint32_t b = parent->child[lpos + 1];
+            if (leaves[a].count + leaves[b].count <= LEAF_CAP * 3 / 4)
+            {
+                leaf &la = leaves[a];
+                leaf &lb = leaves[b];
+                std::copy(lb.keys, lb.keys + lb.count, la.keys + la.count);
+                std::copy(lb.ids, lb.ids + lb.count, la.ids + la.count);
+                la.count += lb.count;
+                parent->sizes[lpos] += parent->sizes[lpos + 1];
+                unlink_leaf(b);
+                remove_child(*parent, lpos + 1);
+                removed = true;
+            }
+        }
+
+        // 逐层向上：内部结点过空时同样与相邻兄弟合并
+        while (removed && depth > 0)
+        {
+            removed = false;
+            inner &n = inners[path[depth].node];
+            inner &gp = inners[path[depth - 1].node];
+            int npos = path[depth - 1].pos;
+            if (n.count == 0)
+            {
+                free_inners.push_back(path[depth].node);
+                remove_child(gp, npos);
+                removed = true;
+            }
+            else if (n.count < INNER_CAP / 4 && gp.count > 1)
+            {
+                int lpos = npos > 0 ? npos - 1 : npos;
+                inner &a = inners[gp.child[lpos]];
+                inner &b = inners[gp.child[lpos + 1]];
+                if (a.count + b.count <= INNER_CAP * 3 / 4)
+                {
+                    a.seps[a.count - 1] = gp.seps[lpos];
+                    std::copy(b.seps, b.seps + b.count - 1, a.seps + a.count);
+                    std::copy(b.child, b.child + b.count, a.child + a.count);
+                    std::copy(b.sizes, b.sizes + b.count, a.sizes + a.count);
+                    a.count += b.count;
+                    gp.sizes[lpos] += gp.sizes[lpos + 1];
+                    free_inners.push_back(gp.child[lpos + 1]);
+                    remove_child(gp, lpos + 1);
+                    removed = true;
+                }
+            }
+            depth--;
+        }
+
+        // 根只剩一个子结点时降低树高
+        while (height > 0 && inners[root].count == 1)
+        {
+            free_inners.push_back(root);
+            root = inners[root].child[0];
+            height--;
+        }
+        return at;
+    }
+
+public:
+    /// 按排名先后遍历队伍编号
+    class const_iterator
+    {
+    private:
+        const bptree *tree;
+        uint32_t x;
+        int pos;
+
+    public:
+        const_iterator(const bptree *t, uint32_t n, int p) : tree(t), x(n), pos(p) {}
+        int operator*() const { return tree->leaves[x].ids[pos]; }
+        const_iterator &operator++()
+        {
+            if (++pos == tree->leaves[x].count)
+            {
+                x = tree->leaves[x].next;
+                pos = 0;
+            }
+            return *this;
+        }
+        bool operator==(const const_iterator &o) const { return x == o.x && pos == o.pos; }
+        bool operator!=(const const_iterator &o) const { return !(*this == o); }
+    };
+
+    const_iterator begin() const { return const_iterator(this, head, 0); }
+    const_iterator end() const { return const_iterator(this, NONE, 0); }
+
+    size_t size() const { return total; }
+    bool empty() const { return total == 0; }
+
+    void clear()
+    {
+        leaves.clear();
+        inners.clear();
+        free_leaves.clear();
+        free_inners.clear();
+        root = head = tail = NONE;
+        height = 0;
+        total = 0;
+        clear_dirty();
+    }
+
+    /**
+     * 由按排名键升序排列的 n 个队伍编号整体建树，替换原有内容，keyOf(id) 给出排名键
+     * 叶子与内部结点自底向上逐层填到 3/4 容量（为之后的插入留出余地），O(N)
+     */
+    template<class KeyOf>
+    void build(const int *ids, size_t n, KeyOf keyOf)
+    {
+        clear();
+        if (n == 0)
+            return;
+
+        struct built
+        {
+            uint32_t node;
+            uint32_t size;
+            rankingkey first; // 子树中最小的键，用作上一层的分隔键
+        };
+        std::vector<built> level;
+        const size_t leafFill = LEAF_CAP * 3 / 4;
+        size_t leafCount = (n + leafFill - 1) / leafFill;
+        leaves.reserve(leafCount);
+        level.reserve(leafCount);
+        size_t next = 0;
+        for (size_t i = 0; i < leafCount; ++i)
+        {
+            size_t take = (n - next) / (leafCount - i); // 均分，相邻叶子的条目数至多差 1
+            uint32_t x = new_leaf();
+            leaf &l = leaves[x];
+            for (size_t k = 0; k < take; ++k)
+            {
+                l.keys[k] = keyOf(ids[next + k]);
+                l.ids[k] = ids[next + k];
+            }
+            l.count = static_cast<int>(take);
+            l.prev = tail;
+            if (tail != NONE)
+                leaves[tail].next = x;
+            else
+                head = x;
+            tail = x;
+            level.push_back({x, static_cast<uint32_t>(take), l.keys[0]});
+            next += take;
+        }
+
+        const size_t innerFill = INNER_CAP * 3 / 4;
+        while (level.size() > 1)
+        {
+            size_t groups = (level.size() + innerFill - 1) / innerFill;
+            std::vector<built> up;
+            up.reserve(groups);
+            size_t from = 0;
+            for (size_t g = 0; g < groups; ++g)
+            {
+                size_t take = (level.size() - from) / (groups - g);
+                uint32_t x = new_inner();
+                inner &in = inners[x];
+                uint32_t sum = 0;
+                for (size_t k = 0; k < take; ++k)
+                {
+                    const built &c = level[from + k];
+                    in.child[k] = c.node;
+                    in.sizes[k] = c.size;
+                    if (k > 0)
+                        in.seps[k - 1] = c.first;
+                    sum += c.size;
+                }
+                in.count = static_cast<int>(take);
+                up.push_back({x, sum, level[from].first});
+                from += take;
+            }
+            level.swap(up);
+            height++;
+        }
+        root = level[0].node;
+        total = n;
+        mark_dirty(0, total);
+    }
+
+    /// 插入条目：其后所有位置的名次都会后移
+    void insert(const rankingkey &key, int id)
+    {
+        size_t pos = insert_at(key, id);
+        mark_dirty(pos, total);
+    }
+
+    /// 删除排名键为 key 的条目，不存在则返回 false；其后所有位置的名次都会前移
+    bool erase(const rankingkey &key)
+    {
+        size_t pos = erase_at(key);
+        if (pos == NPOS)
+            return false;
+        mark_dirty(pos, total);
+        return true;
+    }
+
+    /**
+     * 把条目的排名键由 oldKey 改为 newKey
+     * 条目从位置 p 移到 q，只有 [min(p, q), max(p, q)] 内的名次发生变化
+     */
+    void update(const rankingkey &oldKey, const rankingkey &newKey, int id)
+    {
+        size_t p = erase_at(oldKey);
+        size_t q = insert_at(newKey, id);
+        if (p == NPOS)
+            mark_dirty(q, total);
+        else
+            mark_dirty(std::min(p, q), std::max(p, q) + 1);
+    }
+
+    /// 名次可能已变化的位置区间 [dirty_begin(), dirty_end())，区间为空时 begin >= end
+    size_t dirty_begin() const { return dirty_lo; }
+    size_t dirty_end() const { return std::min(dirty_hi, total); }
+    void clear_dirty()
+    {
+        dirty_lo = NPOS;
+        dirty_hi = 0;
+    }
+    /// 把变化区间重置为 [lo, hi)，用于撤销一批改键之后恢复原先的区间
+    void reset_dirty(size_t lo, size_t hi)
+    {
+        clear_dirty();
+        mark_dirty(lo, hi);
+    }
+
+    /// 指向第 pos 个条目（从 0 开始）的迭代器，越界时为 end()
+    const_iterator at(size_t pos) const
+    {
+        if (pos >= total)
+            return end();
+        uint32_t x = root;
+        for (int level = height; level > 0; --level)
+        {
+            const inner &n = inners[x];
+            int i = 0;
+            while (pos >= n.sizes[i])
+                pos -= n.sizes[i++];
+            x = n.child[i];
+        }
+        return const_iterator(this, x, static_cast<int>(pos));
+    }
+
+    /// 第一个排名键不小于 key 的队伍编号，不存在返回 -1
+    int lower_bound(const rankingkey &key) const
+    {
+        if (root == NONE)
+            return -1;
+        step path[64];
+        uint32_t x = descend(key, path);
+        const leaf &l = leaves[x];
+        int pos = static_cast<int>(std::lower_bound(l.keys, l.keys + l.count, key) - l.keys);
+        if (pos < l.count)
+            return l.ids[pos];
+        return l.next == NONE ? -1 : leaves[l.next].ids[0];
+    }
+
+    /// 排名键严格小于 key 的条目数，即 key 对应队伍的实时名次减一
+    size_t rank(const rankingkey &key) const
+    {
+        if (root == NONE)
+            return 0;
+        size_t r = 0;
+        uint32_t x = root;
+        for (int level = height; level > 0; --level)
+        {
+            const inner &n = inners[x];
+            int pos = route(n, key);
+            for (int i = 0; i < pos; ++i)
+                r += n.sizes[i];
+            x = n.child[pos];
+        }
+        const leaf &l = leaves[x];
+        return r + static_cast<size_t>(std::lower_bound(l.keys, l.keys + l.count, key) - l.keys);
+    }
+
+    /// 排名最靠后的队伍编号，空树返回 -1
+    int last() const { return tail == NONE ? -1 : leaves[tail].ids[leaves[tail].count - 1]; }
+};
+
+#endif // BPTREE_HPP
@@ -0,0 +1,171 @@
+#pragma once
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 比赛状态检查点的二进制格式
+ * 文件由定长的 checkpointheader 与若干节依次组成，每节是同一类型的定长记录数组，起点按 8 字节对齐，
+ * 因此整个文件 mmap 进内存后可以直接按结构体读取，无需逐字段解析。
+ * 格式与本程序的内存布局绑定：头部记录版本号与各记录的大小，任何一项不符都拒绝恢复。
+ */
+struct checkpointheader
+{
+    static constexpr char MAGIC[8] = {'I', 'C', 'P', 'C', 'C', 'K', 'P', 'T'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t team_record_size; // sizeof(team::image)，用于检查布局是否一致
+    uint32_t team_count;
+    uint32_t problem_count;
+    int32_t duration;
+    uint8_t started;
+    uint8_t frozen;
+    uint8_t reserved[2];
+    uint64_t dirty_begin; // 排名索引中名次待刷新的区间
+    uint64_t dirty_end;
+    uint64_t name_bytes; // 队名拼接后的总字节数
+    uint32_t frozen_count; // 本次封榜以来出现冻结题的队伍数
+    uint32_t board_rows; // 上次 FLUSH 的榜单快照行数
+    uint64_t log_records; // 提交日志的总条数
+};
+
+/**
+ * checkpointwriter 类
+ * 在内存中按节拼出检查点，最后写入临时文件、fsync 后改名覆盖目标文件，
+ * 中途失败不会留下残缺的检查点。
+ */
+class checkpointwriter
+{
+private:
+    std::vector<char> data;
+
+    void align()
+    {
+        data.resize((data.size() + 7) & ~size_t(7), 0);
+    }
+
+public:
+    /// 追加一节：n 个类型为 T 的定长记录
+    template<class T>
+    void section(const T *items, size_t n)
+    {
+        align();
+        size_t at = data.size();
+        data.resize(at + sizeof(T) * n);
+        if (n > 0)
+            std::memcpy(data.data() + at, items, sizeof(T) * n);
+    }
+
+    template<class T>
+    void section(const std::vector<T> &items)
+    {
+        section(items.data(), items.size());
+    }
+
+    /// 写出到 path，成功返回 true
+    bool commit(const std::string &path)
+    {
+        align();
+        std::string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            return false;
+        const char *p = data.data();
+        size_t left = data.size();
+        while (left > 0)
+        {
+            ssize_t r = ::write(fd, p, left);
+            if (r < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                ::close(fd);
+                ::unlink(tmp.c_str());
+                return false;
+            }
+            p += r;
+            left -= static_cast<size_t>(r);
+        }
+        bool ok = ::fsync(fd) == 0;
+        ok = ::close(fd) == 0 && ok;
+        if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            ::unlink(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * checkpointreader 类
+ * 只读映射整个检查点文件，按写入顺序逐节取出记录数组（指向映射区，不拷贝）
+ * 越界的节返回 nullptr，调用方据此判定文件损坏
+ */
+class checkpointreader
+{
+private:
+    const char *base = nullptr;
+    size_t size = 0;
+    size_t cursor = 0;
+
+public:
+    checkpointreader() = default;
+    checkpointreader(const checkpointreader &) = delete;
+    checkpointreader &operator=(const checkpointreader &) = delete;
+    ~checkpointreader()
+    {
+        if (base)
+            ::munmap(const_cast<char *>(base), size);
+    }
+
+    /// 映射文件 path，失败返回 false
+    bool open(const char *path)
+    {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        size = static_cast<size_t>(st.st_size);
+        void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            size = 0;
+            return false;
+        }
+        base = static_cast<const char *>(addr);
+        return true;
+    }
+
+    /// 取出下一节的 n 个 T，越界返回 nullptr
+    template<class T>
+    const T *section(size_t n)
+    {
+        static_assert(alignof(T) <= 8, "检查点中的记录最多按 8 字节对齐");
+        cursor = (cursor + 7) & ~size_t(7);
+        if (cursor > size || n > (size - cursor) / sizeof(T))
+            return nullptr;
+        const T *p = reinterpret_cast<const T *>(base + cursor);
+        cursor += sizeof(T) * n;
+        return p;
+    }
+};
+
+#endif // CHECKPOINT_HPP
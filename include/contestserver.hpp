@@ -0,0 +1,213 @@
+#pragma once
+#ifndef CONTESTSERVER_HPP
+#define CONTESTSERVER_HPP
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <unordered_map>
+#include "output.hpp"
+#include "parser.hpp"
+#include "stealingpool.hpp"
+
+/**
+ * contestserver 类
+ * 多比赛模式：每行输入以比赛编号开头，其余部分是该比赛的一条命令，各比赛的输出写到 <dir>/<比赛编号>.out
+ * 调用线程负责读取与分发：把命令追加到所属比赛的待执行缓冲，比赛尚未排队时提交给 stealingpool；
+ * 工作线程每次取走一个比赛攒下的全部命令按顺序执行，执行完若又有新命令则把比赛重新排到队尾。
+ * 同一比赛同一时刻只在一个线程上执行，所以每个比赛的输出与单独运行时逐字节相同，比赛之间互不等待。
+ * 比赛内的 CHECKPOINT 一律拒绝（与 --restore / --journal 不能用于本模式一致）。
+ * 比赛的 parser 在第一次执行时才建立；没有待执行命令时待执行缓冲与输出缓冲都已归还，空闲比赛只保留比赛状态。
+ */
+class contestserver
+{
+private:
+    static constexpr size_t MAX_QUEUED = 16 << 20; // 待执行命令合计超过此字节数时读取线程等待
+    static constexpr size_t RESUME_QUEUED = MAX_QUEUED / 2; // 回落到此值以下时读取线程继续
+    static constexpr size_t MAX_ID = 64; // 比赛编号的最大长度
+
+    struct contest
+    {
+        int fd = -1; // 输出文件，打不开时为 -1，该比赛的命令全部丢弃
+        std::unique_ptr<parser> p; // 第一次执行时建立，只由执行该比赛的工作线程访问
+        std::mutex mutex; // 保护 pending 与 scheduled
+        std::string pending; // 待执行的命令，每条以 '\n' 结尾
+        bool scheduled = false; // 已交给线程池、尚未执行完
+
+        ~contest()
+        {
+            p.reset(); // 先写出剩余输出再关闭文件
+            if (fd >= 0)
+                ::close(fd);
+        }
+    };
+
+    std::string dir;
+    bool history;
+    FlushPolicy policy = FlushPolicy::BATCHED;
+    std::unordered_map<std::string, std::unique_ptr<contest>> contests; // 只由读取线程访问
+    std::string lastId; // 上一行的比赛编号，连续属于同一比赛的行免去查表
+    contest *last = nullptr;
+    std::atomic<size_t> queuedBytes{0}; // 各比赛待执行命令的字节数之和
+    std::mutex flowMutex;
+    std::condition_variable room; // queuedBytes 回落到 RESUME_QUEUED 以下
+    stealingpool<contest *> pool; // 最后声明：析构时先等工作线程退出，再销毁比赛
+
+    static bool valid_id(std::string_view id)
+    {
+        if (id.empty() || id.size() > MAX_ID)
+            return false;
+        for (char c: id)
+        {
+            bool ok = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' ||
+                      c == '-';
+            if (!ok)
+                return false;
+        }
+        return true;
+    }
+
+    /// 第一次见到的比赛：建立输出文件（parser 留到第一次执行时建立）
+    contest *open_contest(std::string_view id)
+    {
+        std::unique_ptr<contest> c = std::make_unique<contest>();
+        std::string path = dir + "/" + std::string(id) + ".out";
+        c->fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (c->fd < 0)
+            std::fprintf(stderr, "cannot open contest output: %s\n", path.c_str());
+        contest *raw = c.get();
+        contests.emplace(std::string(id), std::move(c));
+        return raw;
+    }
+
+    /// 工作线程：执行一个比赛攒下的全部命令
+    void run_contest(contest *c)
+    {
+        std::string work;
+        {
+            std::lock_guard<std::mutex> lock(c->mutex);
+            work.swap(c->pending);
+        }
+        if (!c->p)
+        {
+            c->p = std::make_unique<parser>(0);
+            if (history)
+                c->p->enable_history();
+            c->p->disable_checkpoint(); // 各比赛无法单独恢复，缺省路径还会互相覆盖
+            c->p->set_output_fd(c->fd);
+            c->p->set_flush_policy(policy);
+        }
+        const char *cur = work.data();
+        const char *end = cur + work.size();
+        while (cur < end)
+        {
+            const char *nl = static_cast<const char *>(std::memchr(cur, '\n', static_cast<size_t>(end - cur)));
+            c->p->execute(std::string_view(cur, static_cast<size_t>(nl - cur)));
+            cur = nl + 1;
+        }
+
+        size_t before = queuedBytes.fetch_sub(work.size());
+        if (before > RESUME_QUEUED && before - work.size() <= RESUME_QUEUED)
+        {
+            std::lock_guard<std::mutex> lock(flowMutex);
+            room.notify_one();
+        }
+
+        bool idle;
+        {
+            std::lock_guard<std::mutex> lock(c->mutex);
+            idle = c->pending.empty();
+        }
+        if (idle)
+            c->p->release_output(); // 仍处于 scheduled 状态，其他线程不会同时执行这个比赛
+        {
+            std::lock_guard<std::mutex> lock(c->mutex);
+            if (c->pending.empty())
+            {
+                c->scheduled = false;
+                return;
+            }
+        }
+        pool.submit(c); // 执行期间又来了命令：排到本线程队列的队尾，让同一队列中的其他比赛先执行
+    }
+
+public:
+    /// 各比赛的输出写到目录 dir 下；workers 为工作线程数，history 对每个比赛开启排名历史
+    contestserver(std::string dir_, int workers, bool history_)
+        : dir(std::move(dir_)), history(history_), pool(workers, [this](contest *c) { run_contest(c); })
+    {
+    }
+    contestserver(const contestserver &) = delete;
+    contestserver &operator=(const contestserver &) = delete;
+    ~contestserver() { finish(); }
+
+    /// 各比赛输出的刷新策略，须在第一条命令之前设置
+    void set_flush_policy(FlushPolicy p) { policy = p; }
+
+    /// 分发一行输入：<比赛编号> <命令>
+    void execute(std::string_view line)
+    {
+        size_t begin = line.find_first_not_of(' ');
+        if (begin == std::string_view::npos)
+            return; // 空白行
+        size_t idEnd = std::min(line.find(' ', begin), line.size());
+        std::string_view id = line.substr(begin, idEnd - begin);
+        std::string_view command = idEnd < line.size() ? line.substr(idEnd + 1) : std::string_view();
+
+        contest *c = last;
+        if (!c || id != lastId)
+        {
+            lastId.assign(id);
+            auto it = contests.find(lastId);
+            if (it != contests.end())
+            {
+                c = it->second.get();
+            }
+            else if (valid_id(id))
+            {
+                c = open_contest(id);
+            }
+            else
+            {
+                std::fprintf(stderr, "invalid contest id: %s\n", lastId.c_str());
+                last = nullptr;
+                return;
+            }
+            last = c;
+        }
+        if (c->fd < 0 || command.find_first_not_of(' ') == std::string_view::npos)
+            return;
+
+        size_t bytes = command.size() + 1;
+        size_t queued = queuedBytes.fetch_add(bytes) + bytes; // 先计入再交出，工作线程扣减时不会减到负数
+        bool submit;
+        {
+            std::lock_guard<std::mutex> lock(c->mutex);
+            c->pending.append(command);
+            c->pending.push_back('\n');
+            submit = !c->scheduled;
+            c->scheduled = true;
+        }
+        if (submit)
+            pool.submit(c);
+
+        if (queued > MAX_QUEUED)
+        {
+            std::unique_lock<std::mutex> lock(flowMutex);
+            room.wait(lock, [&] { return queuedBytes.load() <= RESUME_QUEUED; });
+        }
+    }
+
+    /// 等待所有比赛执行完已分发的命令（输出已全部写出）
+    void finish() { pool.wait_idle(); }
+};
+
+#endif // CONTESTSERVER_HPP
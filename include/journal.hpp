@@ -0,0 +1,268 @@
+#pragma once
+#ifndef JOURNAL_HPP
+#define JOURNAL_HPP
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 事件日志（write-ahead journal）的二进制格式
+ * 文件以 8 字节魔数开头，其后是以 64 位字为单位的记录，记录类型在低 3 位：
+ *   SUBMIT ：1 个字，类型 | 状态 << 3 | 题号 << 5 | 时间 << 10 | 队伍编号 << 35
+ *   ADDTEAM：1 个字（类型 | 队名长度 << 3），其后为补齐到 8 字节的队名
+ *   START  ：1 个字，类型 | 时长 << 3 | 题目数 << 35
+ *   FLUSH / FREEZE / SCROLL：1 个字，只有类型
+ * 只记录执行成功、且改变了比赛状态的命令；查询命令不进日志。
+ */
+namespace journalformat
+{
+    constexpr char MAGIC[8] = {'I', 'C', 'P', 'C', 'J', 'R', 'N', '1'};
+
+    enum kind : uint64_t
+    {
+        SUBMIT = 0,
+        ADDTEAM = 1,
+        START = 2,
+        FLUSH = 3,
+        FREEZE = 4,
+        SCROLL = 5
+    };
+
+    constexpr int TIME_BITS = 25;
+} // namespace journalformat
+
+/**
+ * journalwriter 类
+ * 以追加方式写事件日志：记录先攒在内存里，每满 GROUP 条或显式 sync() 时才 write + fdatasync，
+ * 把多次提交的刷盘合并成一次（group commit）。进程崩溃时至多丢失最后一组尚未 sync 的记录。
+ */
+class journalwriter
+{
+private:
+    static constexpr size_t GROUP = 4096; // 每组记录数
+
+    int fd = -1;
+    std::vector<uint64_t> pending;
+    size_t pendingRecords = 0;
+
+    void push(uint64_t w)
+    {
+        pending.push_back(w);
+    }
+
+    void end_record()
+    {
+        if (++pendingRecords >= GROUP)
+            sync();
+    }
+
+public:
+    journalwriter() = default;
+    journalwriter(const journalwriter &) = delete;
+    journalwriter &operator=(const journalwriter &) = delete;
+    ~journalwriter()
+    {
+        if (fd >= 0)
+        {
+            sync();
+            ::close(fd);
+        }
+    }
+
+    bool is_open() const { return fd >= 0; }
+
+    /// 打开（必要时创建）日志文件并定位到末尾，新文件先写入魔数
+    bool open(const char *path)
+    {
+        fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        if (st.st_size == 0)
+        {
+            uint64_t magic;
+            std::memcpy(&magic, journalformat::MAGIC, sizeof(magic));
+            pending.push_back(magic);
+            sync();
+        }
+        pending.reserve(GROUP * 2);
+        return true;
+    }
+
+    void submit(int teamId, int problem, int status, int time)
+    {
+        push(journalformat::SUBMIT | static_cast<uint64_t>(status) << 3 | static_cast<uint64_t>(problem) << 5 |
+             static_cast<uint64_t>(time) << 10 | static_cast<uint64_t>(teamId) << 35);
+        end_record();
+    }
+
+    void addteam(std::string_view name)
+    {
+        push(journalformat::ADDTEAM | static_cast<uint64_t>(name.size()) << 3);
+        size_t words = (name.size() + 7) / 8;
+        size_t at = pending.size();
+        pending.resize(at + words, 0);
+        std::memcpy(pending.data() + at, name.data(), name.size());
+        end_record();
+    }
+
+    void start(int duration, int problems)
+    {
+        push(journalformat::START | static_cast<uint64_t>(static_cast<uint32_t>(duration)) << 3 |
+             static_cast<uint64_t>(problems) << 35);
+        end_record();
+    }
+
+    /// 只有类型的记录：FLUSH / FREEZE / SCROLL
+    void event(journalformat::kind k)
+    {
+        push(k);
+        end_record();
+    }
+
+    /// 检查点已落盘：丢弃此前的全部记录，日志只保留魔数
+    void reset()
+    {
+        if (fd < 0)
+            return;
+        pending.clear();
+        pendingRecords = 0;
+        if (::ftruncate(fd, sizeof(uint64_t)) == 0)
+            ::fdatasync(fd);
+    }
+
+    /// 写出全部待写记录并刷盘
+    void sync()
+    {
+        if (fd < 0 || pending.empty())
+            return;
+        const char *p = reinterpret_cast<const char *>(pending.data());
+        size_t left = pending.size() * sizeof(uint64_t);
+        while (left > 0)
+        {
+            ssize_t r = ::write(fd, p, left);
+            if (r < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                break; // 磁盘错误：放弃本组，比赛继续进行
+            }
+            p += r;
+            left -= static_cast<size_t>(r);
+        }
+        ::fdatasync(fd);
+        pending.clear();
+        pendingRecords = 0;
+    }
+};
+
+/**
+ * journalreader 类
+ * 只读映射整个日志文件，逐条解码记录交给回调；末尾不完整的记录（写到一半时崩溃）被忽略
+ */
+class journalreader
+{
+private:
+    const uint64_t *words = nullptr;
+    size_t count = 0; // 字数（含魔数）
+    size_t bytes = 0;
+
+public:
+    journalreader() = default;
+    journalreader(const journalreader &) = delete;
+    journalreader &operator=(const journalreader &) = delete;
+    ~journalreader()
+    {
+        if (words)
+            ::munmap(const_cast<uint64_t *>(words), bytes);
+    }
+
+    /// 映射 path 并检查魔数；空文件视为没有记录
+    bool open(const char *path)
+    {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        bytes = static_cast<size_t>(st.st_size);
+        if (bytes == 0)
+        {
+            ::close(fd);
+            return true;
+        }
+        void *addr = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            bytes = 0;
+            return false;
+        }
+        ::madvise(addr, bytes, MADV_SEQUENTIAL);
+        words = static_cast<const uint64_t *>(addr);
+        count = bytes / sizeof(uint64_t);
+        return count > 0 && std::memcmp(words, journalformat::MAGIC, sizeof(uint64_t)) == 0;
+    }
+
+    /**
+     * 依次解码每条记录并调用 h 的对应方法：
+     * h.submit(team, problem, status, time)、h.addteam(name)、h.start(duration, problems)、h.event(kind)
+     * 返回处理的记录条数
+     */
+    template<class Handler>
+    size_t replay(Handler &h) const
+    {
+        size_t n = 0;
+        size_t i = 1;
+        while (i < count)
+        {
+            uint64_t w = words[i];
+            switch (w & 7)
+            {
+                case journalformat::SUBMIT:
+                    h.submit(static_cast<int>(w >> 35), static_cast<int>((w >> 5) & 31), static_cast<int>((w >> 3) & 3),
+                             static_cast<int>((w >> 10) & ((uint64_t(1) << journalformat::TIME_BITS) - 1)));
+                    i++;
+                    break;
+                case journalformat::ADDTEAM: {
+                    size_t len = static_cast<size_t>(w >> 3);
+                    size_t words_ = (len + 7) / 8;
+                    if (i + 1 + words_ > count)
+                        return n; // 队名不完整
+                    h.addteam(std::string_view(reinterpret_cast<const char *>(words + i + 1), len));
+                    i += 1 + words_;
+                    break;
+                }
+                case journalformat::START:
+                    h.start(static_cast<int>((w >> 3) & 0xFFFFFFFFu), static_cast<int>(w >> 35));
+                    i++;
+                    break;
+                default:
+                    h.event(static_cast<journalformat::kind>(w & 7));
+                    i++;
+                    break;
+            }
+            n++;
+        }
+        return n;
+    }
+};
+
+#endif // JOURNAL_HPP
@@ -0,0 +1,208 @@
+#pragma once
+#ifndef OUTPUT_HPP
+#define OUTPUT_HPP
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unistd.h>
+
+/**
+ * 输出刷新策略
+ * BATCHED：攒满阈值或遇到 END 时才写出（评测 / 回放）
+ * PER_COMMAND：每条命令执行完立即写出（交互式使用）
+ */
+enum class FlushPolicy
+{
+    BATCHED,
+    PER_COMMAND
+};
+
+/**
+ * outputbuffer 类
+ * 进程级的批量输出缓冲：所有命令的输出按顺序追加到同一块可复用缓冲区，
+ * 整数直接格式化为字符，不经过 iostream，减少 write() 系统调用次数。
+ * 缓冲区在第一次写入时才分配，release 后归还，没有输出的 parser 不占这部分内存。
+ */
+class outputbuffer
+{
+private:
+    static constexpr size_t CAPACITY = 1 << 20; // 1MB 缓冲
+    static constexpr size_t THRESHOLD = CAPACITY / 2; // 命令结束时超过该值即写出
+
+    std::unique_ptr<char[]> buf;
+    size_t cap = 0; // 缓冲区未分配时为 0
+    size_t len = 0;
+    int fd = STDOUT_FILENO;
+    FlushPolicy policy = FlushPolicy::BATCHED;
+#if defined(ICPC_STATS)
+    uint64_t written = 0; // 已写出的字节数（仅统计构建）
+#endif
+
+    void write_all(const char *data, size_t size)
+    {
+#if defined(ICPC_STATS)
+        written += size;
+#endif
+        while (size > 0)
+        {
+            ssize_t r = ::write(fd, data, size);
+            if (r < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return; // 输出端已关闭，丢弃剩余数据
+            }
+            data += r;
+            size -= static_cast<size_t>(r);
+        }
+    }
+
+    template<class T>
+    void put_unsigned(T value)
+    {
+        char tmp[24];
+        char *end = tmp + sizeof(tmp);
+        char *p = end;
+        do
+        {
+            *--p = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+        while (value != 0);
+        append(p, static_cast<size_t>(end - p));
+    }
+
+    /// 缓冲区已满：未分配时分配，否则写出
+    void make_room()
+    {
+        if (!buf)
+        {
+            buf.reset(new char[CAPACITY]);
+            cap = CAPACITY;
+        }
+        else
+        {
+            flush();
+        }
+    }
+
+public:
+    outputbuffer() = default;
+    outputbuffer(const outputbuffer &) = delete;
+    outputbuffer &operator=(const outputbuffer &) = delete;
+    ~outputbuffer() { flush(); }
+
+    void set_fd(int target) { fd = target; }
+    void set_policy(FlushPolicy p) { policy = p; }
+    size_t size() const { return len; }
+#if defined(ICPC_STATS)
+    /// 累计输出的字节数（含尚在缓冲区中的部分）
+    uint64_t bytes_written() const { return written + len; }
+#endif
+
+    void append(const char *data, size_t size)
+    {
+        if (len + size > cap)
+        {
+            make_room();
+            if (size > CAPACITY)
+            {
+                write_all(data, size);
+                return;
+            }
+        }
+        std::memcpy(buf.get() + len, data, size);
+        len += size;
+    }
+
+    /**
+     * 取得至少 n 字节的连续可写空间（n 不超过 CAPACITY），写完后用 advance 提交实际写入的长度
+     * 供按行批量格式化的调用方直接写入缓冲区
+     */
+    char *claim(size_t n)
+    {
+        if (len + n > cap)
+            make_room();
+        return buf.get() + len;
+    }
+    void advance(size_t n) { len += n; }
+
+    /// 单次 claim 的上限
+    static constexpr size_t max_claim() { return CAPACITY; }
+
+    void put(char c)
+    {
+        if (len == cap)
+            make_room();
+        buf[len++] = c;
+    }
+
+    /// 写出缓冲区中的全部数据
+    void flush()
+    {
+        if (len > 0)
+        {
+            write_all(buf.get(), len);
+            len = 0;
+        }
+    }
+
+    /// 写出全部数据并归还缓冲区，下次写入时重新分配
+    void release()
+    {
+        flush();
+        buf.reset();
+        cap = 0;
+    }
+
+    /// 每条命令结束时调用：按策略或阈值决定是否写出
+    void commit()
+    {
+        if (policy == FlushPolicy::PER_COMMAND || len >= THRESHOLD)
+            flush();
+    }
+
+    outputbuffer &operator<<(char c)
+    {
+        put(c);
+        return *this;
+    }
+    outputbuffer &operator<<(std::string_view sv)
+    {
+        append(sv.data(), sv.size());
+        return *this;
+    }
+    outputbuffer &operator<<(const char *s) { return *this << std::string_view(s); }
+    outputbuffer &operator<<(const std::string &s) { return *this << std::string_view(s); }
+
+    template<class T, class = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char> &&
+                                               !std::is_same_v<T, bool>>>
+    outputbuffer &operator<<(T value)
+    {
+        if constexpr (std::is_signed_v<T>)
+        {
+            using U = std::make_unsigned_t<T>;
+            if (value < 0)
+            {
+                put('-');
+                put_unsigned(static_cast<U>(U(0) - static_cast<U>(value)));
+            }
+            else
+            {
+                put_unsigned(static_cast<U>(value));
+            }
+        }
+        else
+        {
+            put_unsigned(value);
+        }
+        return *this;
+    }
+};
+
+#endif // OUTPUT_HPP
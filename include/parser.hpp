@@ -1,38 +1,106 @@
 #pragma once
-#include <ostream>
 #ifndef PARSER_HPP
 #define PARSER_HPP
-#include <iostream>
-#include <set>
-#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
-#include <unistd.h>
-#include <unordered_map>
+#include <utility>
 #include <vector>
+#include "boardrenderer.hpp"
+#include "boardsnapshot.hpp"
+#include "checkpoint.hpp"
+#include "journal.hpp"
+#include "output.hpp"
+#include "radixsort.hpp"
+#include "rankhistory.hpp"
+#include "ranking.hpp"
+#include "stats.hpp"
+#include "submissionlog.hpp"
 #include "team.hpp"
+#include "teamindex.hpp"
 #include "token.hpp"
+#include "workerpool.hpp"
 
 /**
- * 关键字 → TokenType 的映射表
+ * 关键字 → TokenType 的查找
  * 用于词法分析阶段，把输入的字符串关键字转成对应的 TokenType
+ * 先按长度、再按首字母分派，最后做一次整体比较：不哈希、不分配
  */
-inline const std::unordered_map<std::string_view, TokenType> keywordMap = {
-        {"ADDTEAM", TokenType::ADDTEAM},
-        {"START", TokenType::START},
-        {"SUBMIT", TokenType::SUBMIT},
-        {"FLUSH", TokenType::FLUSH},
-        {"FREEZE", TokenType::FREEZE},
-        {"SCROLL", TokenType::SCROLL},
-        {"QUERY_RANKING", TokenType::QUERY_RANKING},
-        {"QUERY_SUBMISSION", TokenType::QUERY_SUBMISSION},
-        {"END", TokenType::END},
-        {"Accepted", TokenType::ACCEPTED},
-        {"Wrong_Answer", TokenType::WRONG_ANSWER},
-        {"Runtime_Error", TokenType::RUNTIME_ERROR},
-        {"Time_Limit_Exceed", TokenType::TIME_LIMIT_EXCEED}};
-
-inline std::string tokenTypeToStatusString(const TokenType &t)
+constexpr TokenType lookupKeyword(std::string_view sv)
+{
+    switch (sv.size())
+    {
+        case 3:
+            return sv == "END" ? TokenType::END : TokenType::UNKNOWN;
+        case 5:
+            if (sv[0] == 'F')
+                return sv == "FLUSH" ? TokenType::FLUSH : TokenType::UNKNOWN;
+            if (sv[3] == 'R')
+                return sv == "START" ? TokenType::START : TokenType::UNKNOWN;
+            return sv == "STATS" ? TokenType::STATS : TokenType::UNKNOWN;
+        case 6:
+            if (sv[0] == 'F')
+                return sv == "FREEZE" ? TokenType::FREEZE : TokenType::UNKNOWN;
+            if (sv[1] == 'U')
+                return sv == "SUBMIT" ? TokenType::SUBMIT : TokenType::UNKNOWN;
+            return sv == "SCROLL" ? TokenType::SCROLL : TokenType::UNKNOWN;
+        case 7:
+            return sv == "ADDTEAM" ? TokenType::ADDTEAM : TokenType::UNKNOWN;
+        case 8:
+            return sv == "Accepted" ? TokenType::ACCEPTED : TokenType::UNKNOWN;
+        case 10:
+            return sv == "CHECKPOINT" ? TokenType::CHECKPOINT : TokenType::UNKNOWN;
+        case 11:
+            return sv == "QUERY_BOARD" ? TokenType::QUERY_BOARD : TokenType::UNKNOWN;
+        case 12:
+            return sv == "Wrong_Answer" ? TokenType::WRONG_ANSWER : TokenType::UNKNOWN;
+        case 13:
+            if (sv[0] == 'R')
+                return sv == "Runtime_Error" ? TokenType::RUNTIME_ERROR : TokenType::UNKNOWN;
+            if (sv[6] == 'R')
+                return sv == "QUERY_RANKING" ? TokenType::QUERY_RANKING : TokenType::UNKNOWN;
+            return sv == "QUERY_HISTORY" ? TokenType::QUERY_HISTORY : TokenType::UNKNOWN;
+        case 14:
+            return sv == "SCROLL_PREVIEW" ? TokenType::SCROLL_PREVIEW : TokenType::UNKNOWN;
+        case 16:
+            return sv == "QUERY_SUBMISSION" ? TokenType::QUERY_SUBMISSION : TokenType::UNKNOWN;
+        case 17:
+            return sv == "Time_Limit_Exceed" ? TokenType::TIME_LIMIT_EXCEED : TokenType::UNKNOWN;
+        case 18:
+            return sv == "QUERY_LIVE_RANKING" ? TokenType::QUERY_LIVE_RANKING : TokenType::UNKNOWN;
+        default:
+            return TokenType::UNKNOWN;
+    }
+}
+
+static_assert(lookupKeyword("ADDTEAM") == TokenType::ADDTEAM);
+static_assert(lookupKeyword("START") == TokenType::START);
+static_assert(lookupKeyword("SUBMIT") == TokenType::SUBMIT);
+static_assert(lookupKeyword("FLUSH") == TokenType::FLUSH);
+static_assert(lookupKeyword("FREEZE") == TokenType::FREEZE);
+static_assert(lookupKeyword("SCROLL") == TokenType::SCROLL);
+static_assert(lookupKeyword("SCROLL_PREVIEW") == TokenType::SCROLL_PREVIEW);
+static_assert(lookupKeyword("QUERY_RANKING") == TokenType::QUERY_RANKING);
+static_assert(lookupKeyword("QUERY_SUBMISSION") == TokenType::QUERY_SUBMISSION);
+static_assert(lookupKeyword("QUERY_LIVE_RANKING") == TokenType::QUERY_LIVE_RANKING);
+static_assert(lookupKeyword("QUERY_HISTORY") == TokenType::QUERY_HISTORY);
+static_assert(lookupKeyword("QUERY_BOARD") == TokenType::QUERY_BOARD);
+static_assert(lookupKeyword("STATS") == TokenType::STATS);
+static_assert(lookupKeyword("CHECKPOINT") == TokenType::CHECKPOINT);
+static_assert(lookupKeyword("END") == TokenType::END);
+static_assert(lookupKeyword("Accepted") == TokenType::ACCEPTED);
+static_assert(lookupKeyword("Wrong_Answer") == TokenType::WRONG_ANSWER);
+static_assert(lookupKeyword("Runtime_Error") == TokenType::RUNTIME_ERROR);
+static_assert(lookupKeyword("Time_Limit_Exceed") == TokenType::TIME_LIMIT_EXCEED);
+static_assert(lookupKeyword("SCROLLS") == TokenType::UNKNOWN);
+static_assert(lookupKeyword("Team_A") == TokenType::UNKNOWN);
+
+/// 词法分析中的空白符（与 isspace 在 "C" locale 下一致）
+constexpr bool isBlank(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+inline std::string_view tokenTypeToStatusString(const TokenType &t)
 {
     switch (t)
     {
@@ -57,22 +125,58 @@ inline std::string tokenTypeToStatusString(const TokenType &t)
  */
 class parser
 {
+public:
+    /// 一条已解析的 SUBMIT（事件日志回放与流水线模式下成批应用）
+    struct submitrecord
+    {
+        int teamId;
+        int problem;
+        int time;
+        TokenType status;
+    };
+
 private:
     /**
-     * teamName → team 对象
+     * 队伍编号 → team 对象（编号在 ADDTEAM 时由 teamIds 分配）
      */
-    std::unordered_map<std::string, team> teamMap;
+    std::vector<team> teams;
 
     /**
-     * 用于在指针集合中比较 team 指针的大小
+     * teamName → 队伍编号
      */
-    struct TeamPtrLess
+    teamindex teamIds;
+
+    /**
+     * 实时排名索引：按排名键存放全部队伍（开赛后）
+     */
+    rankingindex rankingSet;
+
+    /**
+     * 本次封榜以来出现冻结题的队伍编号，滚榜时据此建立 freezeOrder，无需遍历全部队伍
+     */
+    std::vector<int> frozenTeams;
+
+    /// 上次 FLUSH 时榜单上的一行：队伍编号与当时的通过数、罚时
+    struct boardrow
     {
-        bool operator()(const team *a, const team *b) const { return *a < *b; }
+        int id;
+        int solved;
+        int penalty;
     };
 
-    std::set<team *, TeamPtrLess> rankingSet;
+    /**
+     * 上次 FLUSH 的榜单快照，下标为名次 - 1，供 QUERY_BOARD 按名次区间读取
+     * 只有变化区间内的队伍会改变位置或成绩，flush() 随名次一并改写这一段
+     */
+    std::vector<boardrow> flushedBoard;
 
+    /// 排名集合中的一次改键，SCROLL_PREVIEW 据此倒序撤销
+    struct keychange
+    {
+        rankingkey oldKey;
+        rankingkey newKey;
+        int id;
+    };
 
     /// 比赛是否已经开始
     bool is_started = false;
@@ -81,154 +185,914 @@ private:
     bool is_frozen = false;
 
     /// 题目数量
-    int problem_count;
+    int problem_count = 0;
 
     /// 比赛总时长
-    int duration_time;
+    int duration_time = 0;
+
+    /// 所有命令共用的输出缓冲
+    outputbuffer out;
+
+    /// 滚榜时输出整张榜单，缓存各队的题目状态文本
+    boardrenderer board;
+
+    /// 各命令耗时与内部计数（未定义 ICPC_STATS 时为空实现）
+    commandstats stats;
+
+    /// 按队伍分段的提交日志，供 QUERY_HISTORY 按题目、状态与时间区间查询
+    submissionlog history;
+
+    /// 是否记录排名历史（QUERY_RANKING ... AT time 依赖于此，默认关闭）
+    bool history_mode = false;
+
+    /// 是否接受 CHECKPOINT（多比赛模式下各比赛共用工作目录，且无法从检查点恢复，因此关闭）
+    bool checkpoint_enabled = true;
+
+    /// 可持久化的排名历史，仅在 history_mode 下维护
+    rankhistory rankHistory;
+
+    /// 事件日志：未打开时不记录
+    journalwriter journal;
+
+    /// 共享内存榜单快照：未打开时不发布
+    boardpublisher publisher;
+
+    /// 正在回放事件日志：状态照常更新，但不输出滚榜榜单与名次变化行
+    bool replaying = false;
+
+    /// 回放期间有队伍的排名键变了而排名集合尚未改键
+    bool rankingStale = false;
+
+    /// 并行应用 SUBMIT 批的工作线程，未设置时逐条执行
+    std::unique_ptr<workerpool> workers;
+
+    /// 队伍编号 → 最近一次在哪一批中改过键（与 batchEpoch 比较），供 apply_submits 只记录每队最初的键
+    std::vector<uint32_t> batchMark;
+    uint32_t batchEpoch = 0;
+
+    /// 开启工作线程后逐行执行时尚未应用的连续 SUBMIT，遇到其他命令或攒满 SUBMIT_BATCH 条时成批应用
+    std::vector<submitrecord> pendingSubmits;
+
+    static constexpr size_t PARALLEL_MIN = 256; // 少于此数的批逐条执行
+    static constexpr size_t SUBMIT_BATCH = 4096; // 逐行执行时一批 SUBMIT 的上限
+    static constexpr size_t REBUILD_RATIO = 8; // 改键队伍超过总数的 1/8 时整体重建排名集合
+
+    /**
+     * 把日志记录直接应用到比赛状态，不经过分词与队名查找（队名仅在 ADDTEAM 时驻留一次）
+     * 回放过程不可观察，因此 SUBMIT 引起的改键推迟到需要排名集合时一次重建；
+     * 两次刷新之间没有查询，前一次 FLUSH 的结果会被后一次（或 SCROLL 开头的刷新）完整覆盖，
+     * 所以只执行 lastFlush 指出的最后一次
+     */
+    struct replayer
+    {
+        parser &p;
+        size_t lastFlush; // 需要执行的 FLUSH 的记录序号，没有时为 SIZE_MAX
+        size_t index = 0;
+        std::vector<submitrecord> batch; // 尚未应用的连续 SUBMIT
+
+        replayer(parser &p_, size_t lastFlush_) : p(p_), lastFlush(lastFlush_) {}
+
+        void addteam(std::string_view name)
+        {
+            drain();
+            if (!p.is_started)
+                p.apply_addteam(name);
+            index++;
+        }
+        void start(int duration, int problems)
+        {
+            drain();
+            if (!p.is_started)
+                p.apply_start(duration, problems);
+            index++;
+        }
+
+        /// 应用攒下的 SUBMIT，其他记录与回放结束前调用
+        void drain()
+        {
+            p.apply_submits(batch.data(), batch.size());
+            batch.clear();
+        }
+        void submit(int teamId, int problem, int status, int time)
+        {
+            if (static_cast<size_t>(teamId) < p.teams.size() && problem < MAX_PROBLEMS) // 跳过损坏的记录
+                batch.push_back(
+                        {teamId, problem, time, static_cast<TokenType>(static_cast<int>(TokenType::ACCEPTED) + status)});
+            index++;
+        }
+        void event(journalformat::kind k)
+        {
+            drain();
+            if (k == journalformat::FLUSH && index == lastFlush)
+            {
+                p.sync_ranking();
+                p.flush();
+            }
+            else if (k == journalformat::FREEZE)
+            {
+                p.is_frozen = true;
+            }
+            else if (k == journalformat::SCROLL && p.is_frozen)
+            {
+                p.sync_ranking();
+                p.apply_scroll();
+            }
+            index++;
+        }
+    };
+
+    /// 找出最后一次 FLUSH 的记录序号（其后若还有 SCROLL 则无需单独执行）
+    struct flushfinder
+    {
+        size_t last = SIZE_MAX;
+        size_t index = 0;
+
+        void addteam(std::string_view) { index++; }
+        void start(int, int) { index++; }
+        void submit(int, int, int, int) { index++; }
+        void event(journalformat::kind k)
+        {
+            if (k == journalformat::FLUSH)
+                last = index;
+            else if (k == journalformat::SCROLL)
+                last = SIZE_MAX;
+            index++;
+        }
+    };
+
+    /**
+     * 按当前排名键整体重建排名集合：基数排序后自底向上建树，O(N)
+     * 无法得知哪些位置变了，变化区间置为全部位置，之后的刷新会改写整张榜单（结果与逐条改键相同）
+     */
+    void sync_ranking()
+    {
+        if (!rankingStale)
+            return;
+        std::vector<int> order;
+        radixsort::sort_by_key(order, teams.size(), [this](int id) { return teams[id].get_key(); }, workers.get());
+        rankingSet.build(order.data(), order.size(), [this](int id) { return teams[id].get_key(); });
+        rankingSet.reset_dirty(0, order.size());
+        rankingStale = false;
+    }
+
+    /**
+     * 解析 QUERY_HISTORY 的 PROBLEM=p 与 STATUS=s
+     * p 须为 ALL 或本场比赛的一个题号字母，s 须为 ALL 或四种评测结果之一；ALL 解析为 submissionlog::ANY
+     */
+    bool parse_history_filter(const token *problemToken, const token *statusToken, int &problem, int &status) const
+    {
+        constexpr std::string_view problemKey = "PROBLEM=";
+        constexpr std::string_view statusKey = "STATUS=";
+        if (!problemToken || !statusToken || problemToken->value.substr(0, problemKey.size()) != problemKey ||
+            statusToken->value.substr(0, statusKey.size()) != statusKey)
+            return false;
+        std::string_view problemName = problemToken->value.substr(problemKey.size());
+        std::string_view statusName = statusToken->value.substr(statusKey.size());
+
+        if (problemName == "ALL")
+            problem = submissionlog::ANY;
+        else if (problemName.size() == 1 && problemName[0] >= 'A' && problemName[0] - 'A' < problem_count)
+            problem = problemName[0] - 'A';
+        else
+            return false;
+
+        if (statusName == "ALL")
+        {
+            status = submissionlog::ANY;
+            return true;
+        }
+        status = submissionlog::status_code(lookupKeyword(statusName));
+        return status != submissionlog::ANY;
+    }
 
 public:
-    parser() { teamMap.reserve(10000); }
-    int parse_int(const std::string_view &sv)
+    /// expectedTeams 为预留的队伍数（多比赛模式下各比赛按 0 起步，按需增长）
+    explicit parser(size_t expectedTeams = 10000)
+    {
+        teams.reserve(expectedTeams);
+        teamIds.reserve(expectedTeams);
+    }
+    parser(const parser &) = delete;
+    parser &operator=(const parser &) = delete;
+    void set_flush_policy(FlushPolicy policy) { out.set_policy(policy); }
+    /// 把输出重定向到文件描述符 fd（基准测试时写到 /dev/null）
+    void set_output_fd(int fd) { out.set_fd(fd); }
+    /// 写出缓冲中的输出并归还缓冲区（多比赛模式下比赛暂时没有待执行的命令时调用）
+    void release_output() { out.release(); }
+    /// 开启排名历史记录（须在 START 之前调用）
+    void enable_history() { history_mode = true; }
+    /// 拒绝 CHECKPOINT 命令
+    void disable_checkpoint() { checkpoint_enabled = false; }
+    /// 用 n 个工作线程（含调用线程）并行应用 SUBMIT 批，n 为 1 时逐条执行
+    void set_workers(int n) { workers = n > 1 ? std::make_unique<workerpool>(n) : nullptr; }
+    /// 队名驻留表与开赛状态，流水线模式的解析线程据此建立自己的副本
+    const teamindex &team_index() const { return teamIds; }
+    bool started() const { return is_started; }
+    /// 把之后执行成功的状态变更命令追加到事件日志 path
+    bool open_journal(const char *path) { return journal.open(path); }
+
+    /**
+     * 打开共享内存榜单快照 path，先发布当前的榜单（可在恢复检查点或回放日志之后调用），
+     * 之后每次 FLUSH（以及 FREEZE 改变封榜状态时）都会更新
+     */
+    bool open_publisher(const char *path)
+    {
+        if (!publisher.open(path))
+            return false;
+        publish(0, 0);
+        return publisher.is_open();
+    }
+
+    /**
+     * 回放事件日志 path，把其中的命令依次应用到当前状态，不产生任何输出
+     * 可接在 restore_checkpoint 之后：CHECKPOINT 成功时日志被清空，日志中只有检查点之后的命令
+     * 返回回放的记录条数，文件无法打开或不是事件日志时返回 -1
+     */
+    long long replay_journal(const char *path)
     {
+        journalreader r;
+        if (!r.open(path))
+            return -1;
+        flushfinder f;
+        r.replay(f);
+        replaying = true;
+        replayer h(*this, f.last);
+        size_t n = r.replay(h);
+        h.drain();
+        sync_ranking();
+        replaying = false;
+        return static_cast<long long>(n);
+    }
+
+    /**
+     * 把完整的比赛状态写成检查点文件（格式见 checkpoint.hpp）
+     * 各节依次为：队伍状态、队名偏移与队名、按排名键排序的队伍编号、冻结队伍、榜单快照、各队提交日志
+     */
+    bool save_checkpoint(const std::string &path) const
+    {
+        size_t n = teams.size();
+        checkpointheader h{};
+        std::memcpy(h.magic, checkpointheader::MAGIC, sizeof(h.magic));
+        h.version = checkpointheader::VERSION;
+        h.team_record_size = sizeof(team::image);
+        h.team_count = static_cast<uint32_t>(n);
+        h.problem_count = static_cast<uint32_t>(problem_count);
+        h.duration = duration_time;
+        h.started = is_started;
+        h.frozen = is_frozen;
+        h.dirty_begin = rankingSet.dirty_begin();
+        h.dirty_end = rankingSet.dirty_end();
+        h.frozen_count = static_cast<uint32_t>(frozenTeams.size());
+        h.board_rows = static_cast<uint32_t>(flushedBoard.size());
+
+        std::vector<team::image> images;
+        std::vector<uint32_t> nameOffsets;
+        std::string names;
+        images.reserve(n);
+        nameOffsets.reserve(n + 1);
+        nameOffsets.push_back(0);
+        for (const team &t: teams)
+        {
+            images.push_back(t.save());
+            names += t.get_name();
+            nameOffsets.push_back(static_cast<uint32_t>(names.size()));
+        }
+        h.name_bytes = names.size();
+
+        std::vector<int> order;
+        order.reserve(rankingSet.size());
+        for (int id: rankingSet)
+            order.push_back(id);
+
+        std::vector<uint32_t> logCounts(n, 0);
+        std::vector<uint32_t> logRecords;
+        for (size_t id = 0; id < n; ++id)
+        {
+            history.for_each_packed(static_cast<int>(id), [&](uint32_t r) {
+                logRecords.push_back(r);
+                logCounts[id]++;
+            });
+        }
+        h.log_records = logRecords.size();
+
+        checkpointwriter w;
+        w.section(&h, 1);
+        w.section(images);
+        w.section(nameOffsets);
+        w.section(names.data(), names.size());
+        w.section(order);
+        w.section(frozenTeams);
+        w.section(flushedBoard);
+        w.section(logCounts);
+        w.section(logRecords);
+        return w.commit(path);
+    }
+
+    /**
+     * 从检查点恢复比赛状态，只能在尚未执行任何命令时调用；文件缺失、版本或布局不符、内容越界或不一致时返回 false，
+     * 此时比赛状态保持不变
+     * 排名索引由已排序的队伍编号整体建树，O(N)，不逐条插入
+     */
+    bool restore_checkpoint(const char *path)
+    {
+        if (!teams.empty() || is_started)
+            return false;
+        checkpointreader r;
+        if (!r.open(path))
+            return false;
+        const checkpointheader *h = r.section<checkpointheader>(1);
+        if (!h || std::memcmp(h->magic, checkpointheader::MAGIC, sizeof(h->magic)) != 0 ||
+            h->version != checkpointheader::VERSION || h->team_record_size != sizeof(team::image) ||
+            h->problem_count > static_cast<uint32_t>(MAX_PROBLEMS))
+            return false;
+        size_t n = h->team_count;
+        const team::image *images = r.section<team::image>(n);
+        const uint32_t *nameOffsets = r.section<uint32_t>(n + 1);
+        const char *names = r.section<char>(h->name_bytes);
+        const int *order = r.section<int>(h->started ? n : 0);
+        const int *frozen = r.section<int>(h->frozen_count);
+        const boardrow *board = r.section<boardrow>(h->board_rows);
+        const uint32_t *logCounts = r.section<uint32_t>(n);
+        const uint32_t *logRecords = r.section<uint32_t>(h->log_records);
+        if (!images || !nameOffsets || !names || !order || !frozen || !board || !logCounts || !logRecords)
+            return false;
+
+        // 先在局部变量中整体校验（下标与区间、各队状态、队名不重复、排名顺序与队名名次、提交记录），
+        // 全部通过后才改动状态；变化区间为空时 dirty_begin 不小于 dirty_end，不作限制
+        auto validId = [n](int id) { return id >= 0 && static_cast<size_t>(id) < n; };
+        uint64_t records = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (nameOffsets[i] > nameOffsets[i + 1] || nameOffsets[i + 1] > h->name_bytes)
+                return false;
+            records += logCounts[i];
+        }
+        if (records != h->log_records || (h->dirty_begin < h->dirty_end && h->dirty_end > n) ||
+            h->board_rows > n || !std::all_of(frozen, frozen + h->frozen_count, validId) ||
+            !std::all_of(board, board + h->board_rows, [&](const boardrow &b) { return validId(b.id); }) ||
+            !std::all_of(logRecords, logRecords + h->log_records, [&](uint32_t rec) {
+                return submissionlog::problem_of(rec) < static_cast<int>(h->problem_count);
+            }))
+            return false;
+        const uint32_t *teamLog = logRecords;
+        for (size_t i = 0; i < n; ++i)
+        {
+            // 队内提交时间单调不降，submissionlog 的二分与跳跃查找依赖于此
+            for (uint32_t k = 1; k < logCounts[i]; ++k)
+            {
+                if (submissionlog::time_of(teamLog[k]) < submissionlog::time_of(teamLog[k - 1]))
+                    return false;
+            }
+            teamLog += logCounts[i];
+        }
+
+        teamindex ids;
+        std::vector<team> loaded;
+        ids.reserve(n);
+        loaded.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            std::string_view name(names + nameOffsets[i], nameOffsets[i + 1] - nameOffsets[i]);
+            if (!ids.intern(name).second)
+                return false; // 队名重复
+            if (!team::check_image(images[i], static_cast<int>(h->problem_count)))
+                return false;
+            loaded.emplace_back(std::string(name));
+            loaded.back().load(images[i]);
+        }
+        if (h->started)
+        {
+            // order 须是全部队伍编号的一个排列，且按排名键升序；队名名次须是 [0, n) 的一个排列（基数排序以它为下标）
+            std::vector<bool> seen(n);
+            std::vector<bool> nameRanks(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (!validId(order[i]) || seen[order[i]])
+                    return false;
+                seen[order[i]] = true;
+                int nameRank = loaded[i].get_key().get_name_rank();
+                if (!validId(nameRank) || nameRanks[nameRank])
+                    return false;
+                nameRanks[nameRank] = true;
+                if (i > 0 && loaded[order[i]].get_key() < loaded[order[i - 1]].get_key())
+                    return false;
+            }
+        }
+
+        teams = std::move(loaded);
+        teamIds = std::move(ids);
+        is_started = h->started;
+        is_frozen = h->frozen;
+        problem_count = static_cast<int>(h->problem_count);
+        duration_time = h->duration;
+        if (is_started)
+        {
+            rankingSet.build(order, n, [this](int id) { return teams[id].get_key(); });
+            rankingSet.reset_dirty(h->dirty_begin, h->dirty_end);
+        }
+        frozenTeams.assign(frozen, frozen + h->frozen_count);
+        flushedBoard.assign(board, board + h->board_rows);
+        const uint32_t *rec = logRecords;
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (uint32_t k = 0; k < logCounts[i]; ++k)
+                history.append_packed(static_cast<int>(i), *rec++);
+        }
+        return true;
+    }
+    /// 十进制整数，允许一个前导负号
+    static int parse_int(const std::string_view &sv)
+    {
+        bool negative = !sv.empty() && sv[0] == '-';
         int result = 0;
-        for (const char &c: sv)
+        for (const char &c: sv.substr(negative))
         {
             result = result * 10 + (c - '0');
         }
-        return result;
+        return negative ? -result : result;
     }
     /**
      * tokenize
      * 对输入的一整行命令进行分词
      * 按空白符切分，生成 tokenstream
      */
-    tokenstream tokenize(const std::string &input)
+    static tokenstream tokenize(std::string_view input)
     {
-        std::vector<token> tokens;
-        tokens.reserve(input.size() / 2);
+        tokenstream ts;
         size_t pos = 0;
         while (pos < input.length())
         {
-            while (pos < input.length() && isspace(static_cast<unsigned char>(input[pos])))
+            while (pos < input.length() && isBlank(input[pos]))
                 pos++;
             if (pos >= input.length())
                 break;
 
             size_t start = pos;
-            while (pos < input.length() && !isspace(static_cast<unsigned char>(input[pos])))
+            while (pos < input.length() && !isBlank(input[pos]))
                 pos++;
 
             std::string_view sv(input.data() + start, pos - start);
-            token tok;
-            auto it = keywordMap.find(sv);
-            tok.type = (it == keywordMap.end()) ? TokenType::UNKNOWN : it->second;
-            tok.value = sv;
-            tokens.push_back(tok);
+            if (!ts.push({lookupKeyword(sv), sv}))
+                break; // 超出最长命令的部分直接忽略
         }
 
-        return tokenstream(tokens);
+        return ts;
+    }
+
+    /**
+     * 把榜单快照发布到共享段：[pos, end) 为本次 FLUSH 名次变化的区间，另重写变过的题目格
+     * 队伍数或题目数变了（或刚打开共享段）时重新布局，整体写入
+     */
+    void publish(size_t pos, size_t end)
+    {
+        bool relayout = publisher.needs_layout(teams.size(), problem_count);
+        auto nameOf = [this](int id) { return teamIds.name(id); };
+        if (relayout && !publisher.reserve(teams.size(), problem_count, nameOf))
+            return;
+        publisher.begin();
+        if (relayout)
+        {
+            publisher.layout(nameOf);
+            for (size_t id = 0; id < teams.size(); ++id)
+                publisher.set_rank(static_cast<int>(id), teams[id].get_rank());
+            pos = 0;
+            end = flushedBoard.size();
+        }
+        for (; pos < end; ++pos)
+        {
+            const boardrow &row = flushedBoard[pos];
+            publisher.set_row(pos, row.id, row.solved, row.penalty);
+            publisher.set_rank(row.id, static_cast<int>(pos) + 1);
+        }
+        publisher.write_cells([this](int id) -> const team & { return teams[id]; });
+        publisher.set_rows(flushedBoard.size());
+        publisher.set_frozen(is_frozen);
+        publisher.end();
     }
 
+    /**
+     * flush
+     * 刷新榜单名次与榜单快照：只改写自上次刷新以来名次可能变化的位置区间，其余队伍的名次保持不变
+     * 开销与变化区间的长度成正比，而不是与队伍总数成正比
+     */
     void flush()
     {
-        int rank = 1;
-        for (auto ptr: rankingSet)
+        size_t begin = rankingSet.dirty_begin();
+        size_t pos = begin;
+        size_t end = rankingSet.dirty_end();
+        if (pos < end)
         {
-            ptr->get_rank() = rank++;
+            if (flushedBoard.size() < rankingSet.size())
+                flushedBoard.resize(rankingSet.size());
+            for (auto it = rankingSet.at(pos); pos < end; ++it, ++pos)
+            {
+                team &t = teams[*it];
+                t.get_rank() = static_cast<int>(pos) + 1;
+                flushedBoard[pos] = {*it, t.get_solved_count(), t.get_time_punishment()};
+            }
         }
+        rankingSet.clear_dirty();
+        if (publisher.is_open())
+            publish(begin, std::max(begin, end));
     }
 
-    void unfreeze_process(std::set<team *, TeamPtrLess> &freezeOrder, std::ostringstream &out)
+    /**
+     * unfreeze_process
+     * 解冻一道题：取 freezeOrder 中排名最靠后的队伍，解冻其编号最小的冻结题
+     * 仅凭新的排名键计算被取代的队伍，队伍本身在移出与重新插入排名集合之间原地更新
+     * undo 非空时为预演：改键依次记入 undo，且不使榜单缓存失效、不计入统计
+     */
+    void unfreeze_process(rankingindex &freezeOrder, std::vector<keychange> *undo = nullptr)
     {
         if (freezeOrder.empty())
             return;
 
-        // 取排名最靠后且还有冻结题的队伍（freezeOrder 存储 team*）
-        auto rev_it = freezeOrder.rbegin();
-        team *oldPtr = *rev_it; // 指向被处理队伍的指针
-        team &team_ref = *oldPtr; // 使用引用避免按 name 再次在 map 中查找
-        const std::string &teamName = team_ref.get_name();
-        auto &statuses = team_ref.get_submit_status();
+        // 取排名最靠后且还有冻结题的队伍（freezeOrder 以排名键存放队伍编号）
+        int teamId = freezeOrder.last();
+        team &team_ref = teams[teamId];
+
+        // 仅解冻该队编号最小的一道冻结题（由冻结位图 O(1) 得到）
+        int idx = team_ref.lowest_frozen();
+        if (idx < 0)
+        {
+            freezeOrder.erase(team_ref.get_key());
+            return;
+        }
+
+        auto &status = team_ref.get_submit_status()[idx];
+        if (!undo)
+        {
+            board.invalidate(teamId);
+            if (publisher.is_open())
+                publisher.invalidate(teamId, idx);
+            stats.count_unfreeze_step();
+        }
+        if (status.first_ac_time == -1)
+        {
+            // 封榜期间未通过：排名键不变，只清除冻结标记
+            team_ref.unfreeze_problem(idx);
+            if (!team_ref.get_has_frozen())
+                freezeOrder.erase(team_ref.get_key());
+            return;
+        }
+
+        // 在排名集合仍含旧键时，用新键计算将被取代的队伍
+        int penalty = status.first_ac_time + status.error_count * 20;
+        rankingkey newKey = team_ref.key_with_solved(status.first_ac_time, penalty);
+        int displaced = rankingSet.lower_bound(newKey); // O(log N)
+        if (displaced < 0)
+            displaced = rankingSet.last();
+        if (displaced >= 0 && displaced != teamId && !replaying)
+        {
+            out << team_ref.get_name() << " " << teams[displaced].get_name() << " " << team_ref.get_solved_count() + 1
+                << " " << team_ref.get_time_punishment() + penalty << '\n';
+        }
+
+        // 从 freezeOrder 中移除旧键，原地更新后在排名集合中改键
+        rankingkey oldKey = team_ref.get_key();
+        freezeOrder.erase(oldKey);
+
+        team_ref.unfreeze_problem(idx);
+        team_ref.add_solved_time(status.first_ac_time, penalty);
+        rankingSet.update(oldKey, team_ref.get_key(), teamId);
+        if (undo)
+            undo->push_back({oldKey, team_ref.get_key(), teamId});
+        else
+            stats.count_reinsertion();
+
+        if (team_ref.get_has_frozen())
+            freezeOrder.insert(team_ref.get_key(), teamId);
+    }
+    /// 按滚榜顺序解冻 frozenTeams 中的全部冻结题，undo 的含义同 unfreeze_process
+    void unfreeze_all(std::vector<keychange> *undo = nullptr)
+    {
+        rankingindex freezeOrder; // 未解冻的队伍排序
+        for (int id: frozenTeams)
+        {
+            freezeOrder.insert(teams[id].get_key(), id);
+        }
+        while (freezeOrder.size() > 0)
+        {
+            unfreeze_process(freezeOrder, undo);
+        }
+    }
+
+    /// ADDTEAM：驻留队名并新建队伍（开赛时才加入排名集合），重名时返回 false
+    bool apply_addteam(std::string_view name)
+    {
+        if (!teamIds.intern(name).second)
+            return false;
+        teams.emplace_back(std::string(name));
+        return true;
+    }
+
+    /// START：记下时长与题目数，按队名字典序分配名次写入排名键，再按该顺序建立排名集合
+    void apply_start(int duration, int problems)
+    {
+        is_started = true;
+        duration_time = duration;
+        problem_count = std::min(problems, MAX_PROBLEMS); // 每队的题目状态内联存放
+
+        std::vector<int> order(teams.size());
+        for (size_t id = 0; id < teams.size(); ++id)
+            order[id] = static_cast<int>(id);
+        radixsort::sort_by_name(order, [this](int id) { return teamIds.name(id); }, workers.get());
+        for (size_t r = 0; r < order.size(); ++r)
+            teams[order[r]].set_name_rank(static_cast<int>(r));
+        rankingSet.build(order.data(), order.size(), [this](int id) { return teams[id].get_key(); });
+        if (history_mode)
+            rankHistory.start(order, [this](int id) { return teams[id].get_key(); }, 0);
+
+        flush();
+    }
+
+    /// update_team 的返回值中的标志位
+    enum submitchange
+    {
+        KEY_CHANGED = 1, // 排名键已变，oldKey 为变化前的键
+        FIRST_FROZEN = 2 // 该队首次出现冻结题
+    };
+
+    /**
+     * SUBMIT 对队伍 teamId 自身的全部改动（题目状态、最近提交、提交日志），返回 submitchange 标志
+     * 不改动排名集合与 frozenTeams，由调用方按返回值补做；未开启 history_mode 时，
+     * 提交日志分片不同的队伍互不共享可写数据，可以并发调用
+     */
+    int update_team(int teamId, int problemIdx, TokenType status, int submitTime, rankingkey &oldKey)
+    {
+        int changes = 0;
+        team &team_ref = teams[teamId];
+        auto &submitStatus = team_ref.get_submit_status()[problemIdx];
+
+        // 统一计数提交次数（提交次数出现在榜单上，该队的缓存行随之失效）
+        submitStatus.submit_count += 1;
+        history.append(teamId, problemIdx, status, submitTime);
+        board.invalidate(teamId);
 
-        // 仅解冻该队编号最小的一道冻结题
-        size_t idx = statuses.size();
-        for (size_t i = 0; i < statuses.size(); ++i)
+        // 记录 team 级别的最近一次提交（用于时间平局时的判定）
+        team_ref.set_last_submit(problemIdx, status, submitTime);
+
+        // 记录该题最近一次提交状态与时间（用于 ALL 状态 + 指定题目的查询）
+        submitStatus.last_submit_time = submitTime;
+        submitStatus.last_submit_type = status;
+
+        bool already_solved = (submitStatus.state == 1);
+        bool is_ac = (status == TokenType::ACCEPTED);
+
+        if (is_ac)
         {
-            if (statuses[i].state == 2)
+            team_ref.get_submit_status()[problemIdx].last_accept = submitTime;
+            team_ref.set_last_accept(problemIdx, submitTime);
+            if (!already_solved)
             {
-                idx = i;
-                break;
+                if (submitStatus.first_ac_time == -1)
+                {
+                    submitStatus.first_ac_time = submitTime;
+                    if (history_mode)
+                        rankHistory.solve(teamId, submitTime, submitTime + submitStatus.error_count * 20);
+                }
+
+                if (is_frozen)
+                {
+                    // 封榜期间：仅标记冻结，不更新通过与罚时
+                    if (!team_ref.get_has_frozen())
+                        changes |= FIRST_FROZEN;
+                    team_ref.freeze_problem(problemIdx);
+                }
+                else
+                {
+                    // 非封榜：立即生效
+                    oldKey = team_ref.get_key(); // 排序字段将发生变化，由调用方按新旧键改键
+                    submitStatus.state = 1;
+                    team_ref.add_solved_time(submitStatus.first_ac_time,
+                                             submitTime + submitStatus.error_count * 20);
+                    changes |= KEY_CHANGED;
+                }
+            }
+        }
+        else
+        {
+            // 封榜期间且封榜前未通过的题会被冻结（先冻结，以便记下封榜前的错误次数）
+            if (is_frozen && !already_solved)
+            {
+                if (!team_ref.get_has_frozen())
+                    changes |= FIRST_FROZEN;
+                team_ref.freeze_problem(problemIdx);
+            }
+
+            // 非 AC：仅在首次 AC 之前计入错误
+            if (!already_solved && submitStatus.first_ac_time == -1)
+            {
+                submitStatus.error_count += 1;
+            }
+
+            if (status == TokenType::WRONG_ANSWER)
+            {
+                submitStatus.last_wrong = submitTime;
+                team_ref.set_last_wrong(problemIdx, submitTime);
+            }
+            else if (status == TokenType::TIME_LIMIT_EXCEED)
+            {
+                submitStatus.last_tle = submitTime;
+                team_ref.set_last_tle(problemIdx, submitTime);
+            }
+            else if (status == TokenType::RUNTIME_ERROR)
+            {
+                submitStatus.last_re = submitTime;
+                team_ref.set_last_re(problemIdx, submitTime);
             }
         }
+        return changes;
+    }
 
-        // 若没有冻结题则从 freezeOrder 中移除旧键
-        if (idx == statuses.size())
+    /// SUBMIT：队伍 teamId 在 submitTime 以 status 提交第 problemIdx 题
+    void apply_submit(int teamId, int problemIdx, TokenType status, int submitTime)
+    {
+        rankingkey oldKey;
+        int changes = update_team(teamId, problemIdx, status, submitTime, oldKey);
+        if (publisher.is_open())
+            publisher.invalidate(teamId, problemIdx);
+        if (changes & FIRST_FROZEN)
+            frozenTeams.push_back(teamId);
+        if (changes & KEY_CHANGED)
         {
-            team_ref.get_has_frozen() = false;
-            freezeOrder.erase(oldPtr);
-            return;
+            if (replaying && is_started)
+            {
+                rankingStale = true; // 回放时不逐条改键，由 sync_ranking 整体重建
+            }
+            else
+            {
+                rankingSet.update(oldKey, teams[teamId].get_key(), teamId);
+                stats.count_reinsertion();
+            }
         }
+    }
 
-        // 为保持原实现语义：在排名集合仍含旧键时，用轻量快照计算 lower_bound
-        team newKey = *oldPtr; // 在拷贝上修改，避免在集合中直接修改元素
-        auto &new_statuses = newKey.get_submit_status();
-        auto &status = new_statuses[idx];
-        status.state = 0;
-        if (status.first_ac_time != -1)
+    /**
+     * 依次应用一批 SUBMIT，结果与逐条 apply_submit 相同
+     * 批内没有查询、也没有 FREEZE 等改变全局状态的命令，各队的改动只取决于本队的提交顺序，
+     * 因此按提交日志分片把队伍分给各工作线程并行执行 update_team；排名集合在批末统一修复：
+     * 改键的队伍较少时逐队改键（旧键取该队在批内第一次改键前的键），较多时按新键整体重建。
+     * 首次冻结的队伍按其在批内首次出现的顺序记入 frozenTeams，与逐条执行时的顺序一致。
+     * 未设置工作线程、批量过小、尚未开赛或开启了 history_mode（排名历史须按全局时间顺序写入）时逐条执行。
+     */
+    void apply_submits(const submitrecord *recs, size_t n)
+    {
+        if (!workers || workers->size() == 1 || n < PARALLEL_MIN || !is_started || history_mode)
         {
-            status.state = 1;
-            newKey.get_time_punishment() += status.first_ac_time + status.error_count * 20;
-            newKey.add_solved_time(status.first_ac_time);
-            newKey.get_solved_count()++;
+            for (size_t i = 0; i < n; ++i)
+                apply_submit(recs[i].teamId, recs[i].problem, recs[i].status, recs[i].time);
+            return;
         }
 
-        bool any_frozen_left = false;
-        for (const auto &s: new_statuses)
+        struct workerresult
         {
-            if (s.state == 2)
+            std::vector<std::pair<size_t, int>> frozen; // (批内序号, 队伍编号)
+            std::vector<keychange> changed; // 批内改过键的队伍及其最初的键
+        };
+        int w = workers->size();
+        std::vector<workerresult> results(w);
+        history.reserve_teams(teams.size());
+        if (batchMark.size() < teams.size())
+            batchMark.resize(teams.size(), 0);
+        uint32_t epoch = ++batchEpoch;
+        workers->run([&](int k) {
+            workerresult &res = results[k];
+            for (size_t i = 0; i < n; ++i)
             {
-                any_frozen_left = true;
-                break;
+                const submitrecord &r = recs[i];
+                if (submissionlog::shard_of(r.teamId) % w != k)
+                    continue;
+                rankingkey oldKey;
+                int changes = update_team(r.teamId, r.problem, r.status, r.time, oldKey);
+                if (changes & FIRST_FROZEN)
+                    res.frozen.push_back({i, r.teamId});
+                if ((changes & KEY_CHANGED) && batchMark[r.teamId] != epoch)
+                {
+                    batchMark[r.teamId] = epoch;
+                    res.changed.push_back({oldKey, oldKey, r.teamId});
+                }
             }
+        });
+
+        if (publisher.is_open())
+        {
+            for (size_t i = 0; i < n; ++i)
+                publisher.invalidate(recs[i].teamId, recs[i].problem);
+        }
+        std::vector<std::pair<size_t, int>> frozen;
+        size_t changedCount = 0;
+        for (const workerresult &res: results)
+        {
+            frozen.insert(frozen.end(), res.frozen.begin(), res.frozen.end());
+            changedCount += res.changed.size();
         }
-        newKey.get_has_frozen() = any_frozen_left;
+        std::sort(frozen.begin(), frozen.end());
+        for (const auto &f: frozen)
+            frozenTeams.push_back(f.second);
 
-        // 在仍含旧键的排序向量上，用 newKey 计算将被取代的队伍
-        const team *newKeyPtr = &newKey;
-        auto it = rankingSet.lower_bound(const_cast<team *>(newKeyPtr)); // O(log N)
-        if (it == rankingSet.end() && !rankingSet.empty())
-            it = std::prev(rankingSet.end());
-        team *displaced = (it == rankingSet.end()) ? nullptr : *it;
-        if (displaced && displaced->get_name() != teamName)
+        if (changedCount == 0)
+            return;
+        if (replaying || changedCount * REBUILD_RATIO > teams.size())
+        {
+            rankingStale = true;
+            if (!replaying)
+                sync_ranking();
+            return;
+        }
+        for (const workerresult &res: results)
         {
-            out << teamName << " " << displaced->get_name() << " " << newKey.get_problem_solved().size() << " "
-                << newKey.get_time_punishment() << '\n';
+            for (const keychange &c: res.changed)
+            {
+                rankingSet.update(c.oldKey, teams[c.id].get_key(), c.id);
+                stats.count_reinsertion();
+            }
         }
+    }
 
+    /**
+     * 执行一次 SUBMIT 并记入事件日志
+     * 开启工作线程且 apply_submits 可以并行时只攒下，由 drain_submits 成批应用：
+     * SUBMIT 没有输出，execute 在执行其他命令之前、或攒满 SUBMIT_BATCH 条时应用攒下的部分，因此推迟应用不可观察
+     */
+    void submit(int teamId, int problemIdx, TokenType status, int submitTime)
+    {
+        if (workers && is_started && !history_mode)
+        {
+            pendingSubmits.push_back({teamId, problemIdx, submitTime, status});
+        }
+        else
+        {
+            apply_submit(teamId, problemIdx, status, submitTime);
+        }
+        int code = submissionlog::status_code(status);
+        if (journal.is_open() && code != submissionlog::ANY)
+            journal.submit(teamId, problemIdx, code, submitTime);
+    }
 
-        // 从排名集合中移除旧指针，写回新值后再插入
-        rankingSet.erase(oldPtr);
-        freezeOrder.erase(oldPtr);
+    /**
+     * 执行一批已经解析好的 SUBMIT（流水线模式下由解析线程给出队伍编号、题号、状态与时间）并记入事件日志
+     * 与 execute 逐行处理这些 SUBMIT 的效果完全相同（SUBMIT 没有输出）
+     */
+    void execute_submits(const std::vector<submitrecord> &recs)
+    {
+        drain_submits();
+        apply_submits(recs.data(), recs.size());
+        if (journal.is_open())
+        {
+            for (const submitrecord &r: recs)
+                journal.submit(r.teamId, r.problem, submissionlog::status_code(r.status), r.time);
+        }
+        out.commit();
+    }
 
-        teamMap[teamName] = newKey; // 复制更新后的快照到实际存储
-        team *ptr = &teamMap[teamName];
-        rankingSet.insert(ptr);
+    /// 应用 submit 攒下的 SUBMIT，批次耗时计入 SUBMIT 的统计
+    void drain_submits()
+    {
+        if (pendingSubmits.empty())
+            return;
+        uint64_t batchStart = stats.now();
+        apply_submits(pendingSubmits.data(), pendingSubmits.size());
+        pendingSubmits.clear();
+        stats.record_batch(TokenType::SUBMIT, batchStart);
+    }
 
-        if (ptr->get_has_frozen())
-            freezeOrder.insert(ptr);
+    /// SCROLL：解封并逐题解冻，回放时不输出前后两张榜单
+    void apply_scroll()
+    {
+        is_frozen = false;
+        flush();
+        if (!replaying)
+            board.render(out, teams, rankingSet, problem_count);
+        unfreeze_all();
+        frozenTeams.clear();
+        // 滚榜结束后刷新，输出最终正确排名
+        flush();
+        if (!replaying)
+            board.render(out, teams, rankingSet, problem_count);
     }
+
     /**
      * execute
      * 执行一条命令
      * 通过第一个 token 决定命令类型
      */
-    void execute(const std::string &cmd)
+    void execute(std::string_view cmd)
     {
-        std::ostringstream out; // 统一缓冲除滚榜外的输出
+        uint64_t startTime = stats.now();
         tokenstream ts = tokenize(cmd);
 
         // 获取命令关键字
         token *keyToken = ts.get();
+        if (!keyToken)
+            return; // 空白行
+        if (keyToken->type != TokenType::SUBMIT && !pendingSubmits.empty())
+        {
+            // 其他命令可能读取比赛状态，先应用攒下的 SUBMIT；这段耗时已计入 SUBMIT，不算在本命令名下
+            uint64_t drainStart = stats.now();
+            drain_submits();
+            startTime += stats.now() - drainStart;
+        }
 
         switch (keyToken->type)
         {
@@ -242,23 +1106,18 @@ public:
                 if (is_started)
                 {
                     out << "[Error]Add failed: competition has started.\n";
-                    std::string s = out.str();
-                    ssize_t r = ::write(STDOUT_FILENO, s.data(), s.size());
-                    (void) r;
-                    return;
+                    break;
                 }
 
                 token *nameToken = ts.get();
                 if (nameToken)
                 {
-                    std::string teamName(nameToken->value);
-
-                    // 检查重名
-                    if (teamMap.find(teamName) == teamMap.end())
+                    // 检查重名：驻留成功即为新队伍
+                    if (apply_addteam(nameToken->value))
                     {
-                        teamMap.emplace(teamName, team(teamName));
-                        rankingSet.insert(&teamMap[teamName]);
                         out << "[Info]Add successfully.\n";
+                        if (journal.is_open())
+                            journal.addteam(nameToken->value);
                     }
                     else
                     {
@@ -276,33 +1135,18 @@ public:
                 if (is_started)
                 {
                     out << "[Error]Start failed: competition has started.\n";
-                    std::string s = out.str();
-                    ssize_t r = ::write(STDOUT_FILENO, s.data(), s.size());
-                    (void) r;
-                    return;
+                    break;
                 }
 
-                is_started = true;
                 out << "[Info]Competition starts.\n";
 
                 ts.get(); // 跳过 "DURATION"
                 token *duration = ts.get(); // 比赛时长
-                duration_time = parse_int(duration->value);
-
                 ts.get(); // 跳过 "PROBLEM"
                 token *count = ts.get(); // 题目数量
-                problem_count = parse_int(count->value);
-
-                // 初始化排名和每道题的提交状态
-                for (auto ptr: rankingSet)
-                {
-                    team &t = *ptr;
-                    auto &statuses = t.get_submit_status();
-                    statuses.resize(problem_count);
-                    t.get_problem_solved().reserve(problem_count);
-                }
-
-                flush();
+                apply_start(parse_int(duration->value), parse_int(count->value));
+                if (journal.is_open())
+                    journal.start(duration_time, problem_count);
                 break;
             }
 
@@ -319,87 +1163,11 @@ public:
                 ts.get(); // AT
                 token *timeToken = ts.get();
 
-                std::string problemName(problemnameToken->value);
-                std::string teamName(teamnameToken->value);
                 int submitTime = parse_int(timeToken->value);
 
-                int problemIdx = problemName[0] - 'A';
-                auto it_team = teamMap.find(teamName);
-                team &team_ref = it_team->second;
-                team *team_ptr = &team_ref;
-                auto &submitStatus = team_ref.get_submit_status()[problemIdx];
-
-                // 统一计数提交次数
-                submitStatus.submit_count += 1;
-
-                // 记录 team 级别的最近一次提交（用于时间平局时的判定）
-                team_ref.set_last_submit(problemIdx, statusToken->type, submitTime);
-
-                // 记录该题最近一次提交状态与时间（用于 ALL 状态 + 指定题目的查询）
-                submitStatus.last_submit_time = submitTime;
-                submitStatus.last_submit_type = statusToken->type;
-
-                bool already_solved = (submitStatus.state == 1);
-                bool is_ac = (statusToken->type == TokenType::ACCEPTED);
-
-                if (is_ac)
-                {
-                    team_ref.get_submit_status()[problemIdx].last_accept = submitTime;
-                    team_ref.set_last_accept(problemIdx, submitTime);
-                    if (!already_solved)
-                    {
-                        if (submitStatus.first_ac_time == -1)
-                            submitStatus.first_ac_time = submitTime;
-
-                        if (is_frozen)
-                        {
-                            // 封榜期间：仅标记冻结，不更新通过与罚时
-                            submitStatus.state = 2;
-                            team_ref.get_has_frozen() = true;
-                        }
-                        else
-                        {
-                            // 非封榜：立即生效
-                            rankingSet.erase(team_ptr); // 排序字段将发生变化，先移除再更新
-                            submitStatus.state = 1;
-                            team_ref.get_time_punishment() += submitTime + submitStatus.error_count * 20;
-                            team_ref.add_solved_time(submitStatus.first_ac_time);
-                            team_ref.get_solved_count()++;
-                            rankingSet.insert(team_ptr);
-                        }
-                    }
-                }
-                else
-                {
-                    // 非 AC：仅在首次 AC 之前计入错误
-                    if (!already_solved && submitStatus.first_ac_time == -1)
-                    {
-                        submitStatus.error_count += 1;
-                    }
-
-                    // 封榜期间且封榜前未通过的题会被冻结
-                    if (is_frozen && !already_solved)
-                    {
-                        submitStatus.state = 2;
-                        teamMap[teamName].get_has_frozen() = true;
-                    }
-
-                    if (statusToken->type == TokenType::WRONG_ANSWER)
-                    {
-                        submitStatus.last_wrong = submitTime;
-                        team_ref.set_last_wrong(problemIdx, submitTime);
-                    }
-                    else if (statusToken->type == TokenType::TIME_LIMIT_EXCEED)
-                    {
-                        submitStatus.last_tle = submitTime;
-                        team_ref.set_last_tle(problemIdx, submitTime);
-                    }
-                    else if (statusToken->type == TokenType::RUNTIME_ERROR)
-                    {
-                        submitStatus.last_re = submitTime;
-                        team_ref.set_last_re(problemIdx, submitTime);
-                    }
-                }
+                int problemIdx = problemnameToken->value[0] - 'A';
+                int teamId = teamIds.find(teamnameToken->value);
+                submit(teamId, problemIdx, statusToken->type, submitTime);
                 break;
             }
 
@@ -410,6 +1178,8 @@ public:
             case TokenType::FLUSH: {
                 flush();
                 out << "[Info]Flush scoreboard.\n";
+                if (journal.is_open())
+                    journal.event(journalformat::FLUSH);
                 break;
             }
 
@@ -417,97 +1187,222 @@ public:
                 if (is_frozen)
                 {
                     out << "[Error]Freeze failed: scoreboard has been frozen.\n";
-                    std::string s = out.str();
-                    ssize_t r = ::write(STDOUT_FILENO, s.data(), s.size());
-                    (void) r;
-                    return;
+                    break;
                 }
-                // 在设置封榜标志前，快照每支队伍每道题的封榜前统计
-                for (auto &pair: teamMap)
+                // 封榜前的错误次数在各题首次冻结时才记下（见 team::freeze_problem），这里无需遍历队伍
+                is_frozen = true;
+                if (publisher.is_open())
                 {
-                    auto &statuses = pair.second.get_submit_status();
-                    for (auto &s: statuses)
-                    {
-                        s.before_freeze_error_count = s.error_count;
-                    }
+                    publisher.begin();
+                    publisher.set_frozen(true);
+                    publisher.end();
                 }
-                is_frozen = true;
                 out << "[Info]Freeze scoreboard.\n";
+                if (journal.is_open())
+                    journal.event(journalformat::FREEZE);
                 break;
             }
 
             case TokenType::SCROLL: {
                 if (!is_frozen)
                 {
-                    static constexpr const char msg[] = "[Error]Scroll failed: scoreboard has not been frozen.\n";
-                    ssize_t r = ::write(STDOUT_FILENO, msg, sizeof(msg) - 1);
-                    (void) r;
-                    return;
+                    out << "[Error]Scroll failed: scoreboard has not been frozen.\n";
+                    break;
                 }
-                is_frozen = false;
+                out << "[Info]Scroll scoreboard.\n";
+                apply_scroll();
+                if (journal.is_open())
+                    journal.event(journalformat::SCROLL);
+                break;
+            }
+
+            /**
+             * SCROLL_PREVIEW
+             * 预演滚榜：输出 SCROLL 将给出的全部名次变化行，但不解冻任何题目
+             * 只有 frozenTeams 中的队伍会被改动，预演前复制这些队伍，结束后倒序撤销排名集合的改键并还原，
+             * 开销与冻结队伍数及其冻结题数成正比，与队伍总数无关
+             */
+            case TokenType::SCROLL_PREVIEW: {
+                if (!is_frozen)
                 {
-                    static constexpr const char msg[] = "[Info]Scroll scoreboard.\n";
-                    ssize_t r = ::write(STDOUT_FILENO, msg, sizeof(msg) - 1);
-                    (void) r;
+                    out << "[Error]Scroll preview failed: scoreboard has not been frozen.\n";
+                    break;
                 }
-                flush();
-                for (auto ptr: rankingSet)
+                out << "[Info]Preview scroll scoreboard.\n";
+                size_t dirtyBegin = rankingSet.dirty_begin();
+                size_t dirtyEnd = rankingSet.dirty_end();
+                std::vector<team> saved;
+                saved.reserve(frozenTeams.size());
+                for (int id: frozenTeams)
+                    saved.push_back(teams[id]);
+
+                std::vector<keychange> undo;
+                unfreeze_all(&undo);
+
+                for (auto it = undo.rbegin(); it != undo.rend(); ++it)
+                    rankingSet.update(it->newKey, it->oldKey, it->id);
+                for (size_t i = 0; i < frozenTeams.size(); ++i)
+                    teams[frozenTeams[i]] = std::move(saved[i]);
+                rankingSet.reset_dirty(dirtyBegin, dirtyEnd);
+                break;
+            }
+
+            /**
+             * QUERY_RANKING teamName [AT time]
+             * 不带 AT 时输出上次 FLUSH 的名次；带 AT 时由排名历史给出时刻 time 的真实名次（需开启 history_mode）
+             */
+            case TokenType::QUERY_RANKING: {
+                token *nameToken = ts.get();
+                std::string_view teamName = nameToken->value;
+                int teamId = teamIds.find(teamName);
+                token *atToken = ts.get();
+                if (atToken && atToken->value == "AT")
                 {
-                    team &team_ = *ptr;
-                    out << team_.get_name() << " " << team_.get_rank() << " " << team_.get_problem_solved().size()
-                        << " " << team_.get_time_punishment() << " ";
-                    for (const auto &status: team_.get_submit_status())
+                    token *timeToken = ts.get();
+                    if (teamId < 0)
+                        out << "[Error]Query ranking failed: cannot find the team.\n";
+                    else if (!history_mode)
+                        out << "[Error]Query ranking failed: history mode is off.\n";
+                    else if (is_frozen)
+                        out << "[Error]Query ranking failed: scoreboard is frozen.\n"; // 真实排名会泄露封榜后的结果
+                    else if (!timeToken)
+                        out << "[Error]Query ranking failed: invalid arguments.\n";
+                    else
                     {
-                        out << status << " ";
+                        int time = parse_int(timeToken->value);
+                        int rank = rankHistory.started() ? rankHistory.rank_at(teamId, time) : teams[teamId].get_rank();
+                        out << "[Info]Complete query ranking.\n";
+                        out << teamName << " AT " << time << " RANKING " << rank << "\n";
                     }
-                    out << "\n";
+                    break;
                 }
-                std::set<team *, TeamPtrLess> freezeOrder; // 未解冻的队伍排序（指针集合，使用 TeamPtrLess）
-                for (auto &pair: teamMap)
+                if (teamId >= 0)
                 {
-                    team &team_ = pair.second;
-                    if (team_.get_has_frozen())
+                    out << "[Info]Complete query ranking.\n";
+                    if (is_frozen)
                     {
-                        freezeOrder.insert(&team_);
+                        out << "[Warning]Scoreboard is frozen. The ranking may be inaccurate until it were scrolled.\n";
                     }
+                    out << teamName << " NOW AT RANKING " << teams[teamId].get_rank() << "\n";
                 }
-                while (freezeOrder.size() > 0)
+                else
                 {
-                    unfreeze_process(freezeOrder, out);
+                    out << "[Error]Query ranking failed: cannot find the team.\n";
                 }
-                // 滚榜结束后刷新，输出最终正确排名
-                flush();
+                break;
+            }
 
-                for (auto ptr: rankingSet)
+            /**
+             * QUERY_LIVE_RANKING teamName
+             * 查询队伍的实时名次：直接由排名索引的顺序统计求出，不依赖也不改动上次 FLUSH 的名次
+             */
+            case TokenType::QUERY_LIVE_RANKING: {
+                token *nameToken = ts.get();
+                std::string_view teamName = nameToken->value;
+                int teamId = teamIds.find(teamName);
+                if (teamId >= 0)
                 {
-                    team &team_ = *ptr;
-                    out << team_.get_name() << " " << team_.get_rank() << " " << team_.get_problem_solved().size()
-                        << " " << team_.get_time_punishment() << " ";
-                    for (const auto &status: team_.get_submit_status())
+                    out << "[Info]Complete query live ranking.\n";
+                    if (is_frozen)
                     {
-                        out << status << " ";
+                        out << "[Warning]Scoreboard is frozen. The ranking may be inaccurate until it were scrolled.\n";
                     }
-                    out << "\n";
+                    // 开赛前队伍尚未进入排名索引，与 QUERY_RANKING 一致输出当前记录的名次
+                    int liveRank = is_started ? static_cast<int>(rankingSet.rank(teams[teamId].get_key())) + 1
+                                              : teams[teamId].get_rank();
+                    out << teamName << " LIVE AT RANKING " << liveRank << "\n";
+                }
+                else
+                {
+                    out << "[Error]Query live ranking failed: cannot find the team.\n";
                 }
                 break;
             }
 
-            case TokenType::QUERY_RANKING: {
+            /**
+             * QUERY_HISTORY teamName WHERE PROBLEM=p AND STATUS=s FROM t1 TO t2
+             * QUERY_HISTORY teamName WHERE PROBLEM=p AND STATUS=s LAST k
+             * 前者按时间先后列出 [t1, t2] 内满足条件的全部提交，后者给出满足条件的倒数第 k 条提交
+             */
+            case TokenType::QUERY_HISTORY: {
                 token *nameToken = ts.get();
-                std::string teamName(nameToken->value);
-                auto it_rank = teamMap.find(teamName);
-                if (it_rank != teamMap.end())
+                ts.get(); // WHERE
+                token *problemToken = ts.get();
+                ts.get(); // AND
+                token *statusToken = ts.get();
+                token *modeToken = ts.get();
+                token *arg1 = ts.get();
+                token *toToken = ts.get();
+                token *arg2 = ts.get();
+                int problem = 0;
+                int status = 0;
+                bool last = modeToken && modeToken->value == "LAST";
+                bool valid = nameToken && arg1 && parse_history_filter(problemToken, statusToken, problem, status) &&
+                             (last || (modeToken && modeToken->value == "FROM" && toToken && toToken->value == "TO" &&
+                                       arg2));
+                if (!valid)
                 {
-                    out << "[Info]Complete query ranking.\n";
-                    if (is_frozen)
-                    {
-                        out << "[Warning]Scoreboard is frozen. The ranking may be inaccurate until it were scrolled.\n";
-                    }
-                    out << teamName << " NOW AT RANKING " << it_rank->second.get_rank() << "\n";
+                    out << "[Error]Query history failed: invalid arguments.\n";
+                    break;
+                }
+                std::string_view teamName = nameToken->value;
+                int teamId = teamIds.find(teamName);
+                if (teamId < 0)
+                {
+                    out << "[Error]Query history failed: cannot find the team.\n";
+                    break;
+                }
+
+                out << "[Info]Complete query history.\n";
+                auto print = [&](const submissionlog::record &r) {
+                    out << teamName << " " << char('A' + r.problem) << " " << tokenTypeToStatusString(r.status) << " "
+                        << r.time << "\n";
+                };
+                if (last)
+                {
+                    submissionlog::record r;
+                    if (history.kth_last(teamId, problem, status, static_cast<size_t>(parse_int(arg1->value)), r))
+                        print(r);
+                    else
+                        out << "Cannot find any submission.\n";
                 }
                 else
                 {
-                    out << "[Error]Query ranking failed: cannot find the team.\n";
+                    if (history.for_each_between(teamId, problem, status, parse_int(arg1->value),
+                                                 parse_int(arg2->value), print) == 0)
+                        out << "Cannot find any submission.\n";
+                }
+                break;
+            }
+
+            /**
+             * QUERY_BOARD [from] [count]
+             * 从上次 FLUSH 的榜单快照中取名次 from 起的 count 行（缺省为从第 1 名到榜尾）
+             * 每行为 队名 名次 通过数 罚时，不遍历实时排名索引，开销与输出行数成正比
+             */
+            case TokenType::QUERY_BOARD: {
+                token *fromToken = ts.get();
+                token *countToken = ts.get();
+                size_t size = flushedBoard.size();
+                int from = fromToken ? parse_int(fromToken->value) : 1;
+                int count = countToken ? parse_int(countToken->value) : static_cast<int>(size);
+                if (from < 1 || static_cast<size_t>(from) > size || count < 0)
+                {
+                    out << "[Error]Query board failed: rank out of range.\n";
+                    break;
+                }
+                out << "[Info]Complete query board.\n";
+                if (is_frozen)
+                {
+                    out << "[Warning]Scoreboard is frozen. The ranking may be inaccurate until it were scrolled.\n";
+                }
+                size_t begin = static_cast<size_t>(from) - 1;
+                size_t end = begin + std::min(static_cast<size_t>(count), size - begin);
+                for (size_t pos = begin; pos < end; ++pos)
+                {
+                    const boardrow &row = flushedBoard[pos];
+                    out << teams[row.id].get_name() << " " << pos + 1 << " " << row.solved << " " << row.penalty
+                        << "\n";
                 }
                 break;
             }
@@ -516,15 +1411,17 @@ public:
                 token *nameToken = ts.get();
                 ts.get(); // WHERE
                 token *problemToken = ts.get();
-                std::string problemName(problemToken->value.substr(8, problemToken->value.length() - 8));
+                std::string_view problemName = problemToken->value.substr(8); // 跳过 "PROBLEM="
                 ts.get(); // AND
                 token *statusToken = ts.get();
-                std::string statusName(statusToken->value.substr(7, statusToken->value.length() - 7));
-                std::string teamName(nameToken->value);
-                if (teamMap.find(teamName) != teamMap.end())
+                std::string_view statusName = statusToken->value.substr(7); // 跳过 "STATUS="
+                TokenType statusType = lookupKeyword(statusName);
+                std::string_view teamName = nameToken->value;
+                int teamId = teamIds.find(teamName);
+                if (teamId >= 0)
                 {
                     out << "[Info]Complete query submission.\n";
-                    auto &team_ = teamMap[teamName];
+                    auto &team_ = teams[teamId];
                     bool is_search_all_problems = (problemName == "ALL");
                     bool is_search_all_status = (statusName == "ALL");
                     auto &statuses = team_.get_submit_status();
@@ -541,7 +1438,7 @@ public:
                     else if (is_search_all_status && !is_search_all_problems)
                     {
                         int tmp = problemName[0] - 'A';
-                        if (tmp < 0 || static_cast<size_t>(tmp) >= statuses.size())
+                        if (tmp < 0 || tmp >= problem_count)
                         {
                             out << "Cannot find any submission.\n";
                         }
@@ -563,31 +1460,30 @@ public:
                     else if (!is_search_all_status && is_search_all_problems)
                     {
                         // 针对指定状态在所有题目的查询，直接使用 team 级别记录
-                        std::string target = statusName;
                         int bestTime = -1;
                         char bestProblem = 'A';
-                        if (target == "Accepted")
+                        if (statusType == TokenType::ACCEPTED)
                         {
                             auto &p = team_.get_last_accept();
                             bestTime = p.second;
                             if (p.first >= 0)
                                 bestProblem = char('A' + p.first);
                         }
-                        else if (target == "Wrong_Answer")
+                        else if (statusType == TokenType::WRONG_ANSWER)
                         {
                             auto &p = team_.get_last_wrong();
                             bestTime = p.second;
                             if (p.first >= 0)
                                 bestProblem = char('A' + p.first);
                         }
-                        else if (target == "Time_Limit_Exceed")
+                        else if (statusType == TokenType::TIME_LIMIT_EXCEED)
                         {
                             auto &p = team_.get_last_tle();
                             bestTime = p.second;
                             if (p.first >= 0)
                                 bestProblem = char('A' + p.first);
                         }
-                        else if (target == "Runtime_Error")
+                        else if (statusType == TokenType::RUNTIME_ERROR)
                         {
                             auto &p = team_.get_last_re();
                             bestTime = p.second;
@@ -603,7 +1499,7 @@ public:
                     else
                     {
                         int tmp = problemName[0] - 'A';
-                        if (tmp < 0 || static_cast<size_t>(tmp) >= statuses.size())
+                        if (tmp < 0 || tmp >= problem_count)
                         {
                             out << "Cannot find any submission.\n";
                         }
@@ -612,13 +1508,13 @@ public:
                             size_t idx = static_cast<size_t>(tmp);
                             auto &s = statuses[idx];
                             int t = -1;
-                            if (statusName == "Accepted")
+                            if (statusType == TokenType::ACCEPTED)
                                 t = s.last_accept;
-                            else if (statusName == "Wrong_Answer")
+                            else if (statusType == TokenType::WRONG_ANSWER)
                                 t = s.last_wrong;
-                            else if (statusName == "Time_Limit_Exceed")
+                            else if (statusType == TokenType::TIME_LIMIT_EXCEED)
                                 t = s.last_tle;
-                            else if (statusName == "Runtime_Error")
+                            else if (statusType == TokenType::RUNTIME_ERROR)
                                 t = s.last_re;
 
                             if (t == -1)
@@ -635,20 +1531,68 @@ public:
                 break;
             }
 
+            /**
+             * CHECKPOINT [path]
+             * 把当前比赛状态写入检查点文件（缺省为 contest.ckpt），之后可用 --restore 从该文件继续
+             */
+            case TokenType::CHECKPOINT: {
+                token *pathToken = ts.get();
+                if (history_mode)
+                {
+                    out << "[Error]Checkpoint failed: history mode is not supported.\n";
+                    break;
+                }
+                if (!checkpoint_enabled)
+                {
+                    out << "[Error]Checkpoint failed: server mode is not supported.\n";
+                    break;
+                }
+                std::string path = pathToken ? std::string(pathToken->value) : std::string("contest.ckpt");
+                if (save_checkpoint(path))
+                {
+                    journal.reset(); // 检查点已包含日志中的全部命令
+                    out << "[Info]Checkpoint saved.\n";
+                }
+                else
+                    out << "[Error]Checkpoint failed: cannot write file.\n";
+                break;
+            }
+
+            /**
+             * STATS
+             * 输出各命令的耗时分布（HDR 直方图分位数）与内部计数，仅在以 ICPC_STATS 构建时可用
+             */
+            case TokenType::STATS: {
+#if defined(ICPC_STATS)
+                out << "[Info]Complete stats.\n";
+                stats.report(out, out.bytes_written());
+#else
+                out << "[Error]Stats failed: built without ICPC_STATS.\n";
+#endif
+                break;
+            }
+
             case TokenType::END: {
                 out << "[Info]Competition ends.\n";
+                out.flush();
+                journal.sync();
                 break;
             }
 
             default:
                 break;
         }
-        // 统一在函数末尾一次性输出（使用 write() 直接写入标准输出）
-        std::string outputStr = out.str();
-        if (!outputStr.empty())
+        // 由输出缓冲按刷新策略决定是否写出
+        out.commit();
+        if (keyToken->type == TokenType::SUBMIT && !pendingSubmits.empty())
+        {
+            stats.defer(startTime); // 本条已攒下，待所在批次应用后连同分摊的批次耗时一并计入
+            if (pendingSubmits.size() >= SUBMIT_BATCH)
+                drain_submits();
+        }
+        else
         {
-            ssize_t result = ::write(STDOUT_FILENO, outputStr.data(), outputStr.size());
-            (void) result; // 避免未使用警告
+            stats.record(keyToken->type, startTime);
         }
     }
 };
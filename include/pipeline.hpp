@@ -0,0 +1,230 @@
+#pragma once
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "parser.hpp"
+#include "spscring.hpp"
+#include "teamindex.hpp"
+#include "token.hpp"
+
+/**
+ * ingestpipeline 类
+ * 三级流水线：读取线程按整行切块，解析线程把每行转成命令记录，调用线程（执行级）按顺序执行
+ * 各级之间以 spscring 传递数据块指针，数据块在三级之间循环使用，运行中不再分配内存。
+ * 只有执行级改动比赛状态并写输出，命令按输入顺序逐条执行，输出与单线程模式逐字节相同。
+ *
+ * 解析线程为 SUBMIT 直接给出队伍编号：它按输入顺序重放 ADDTEAM / START 对队名表的影响，
+ * 维护一份与 parser 内部编号完全一致的队名表副本，执行级因此跳过分词与队名哈希。
+ * 其余命令（以及无法识别的 SUBMIT）保留原始文本，由执行级交给 parser::execute。
+ */
+class ingestpipeline
+{
+private:
+    static constexpr size_t CHUNKS = 8; // 流转中的数据块个数
+    static constexpr size_t CHUNK_BYTES = 1 << 18; // 数据块初始容量，单行更长时按需扩大
+
+    /// 一条命令记录：teamId >= 0 时为已解析的 SUBMIT，否则按 line 原文执行
+    struct command
+    {
+        std::string_view line;
+        int teamId;
+        int problem;
+        int time;
+        TokenType status;
+    };
+
+    /// 若干整行输入及其解析结果
+    struct chunk
+    {
+        std::vector<char> data = std::vector<char>(CHUNK_BYTES);
+        size_t size = 0;
+        std::vector<command> commands;
+        bool last = false; // 输入结束后的最后一块
+    };
+
+    parser &p;
+    int fd;
+    std::vector<std::unique_ptr<chunk>> pool;
+    spscring<chunk *, CHUNKS> freeChunks; // 执行级 → 读取级
+    spscring<chunk *, CHUNKS> readChunks; // 读取级 → 解析级
+    spscring<chunk *, CHUNKS> parsedChunks; // 解析级 → 执行级
+
+    teamindex names; // 解析线程的队名表副本
+    bool started;
+
+    /// 读取级：每块只含整行，不完整的末行移到下一块开头
+    void read_stage()
+    {
+        std::vector<char> carry;
+        for (;;)
+        {
+            chunk *c = freeChunks.pop();
+            if (c->data.size() < carry.size() + CHUNK_BYTES / 2)
+                c->data.resize(carry.size() + CHUNK_BYTES);
+            std::memcpy(c->data.data(), carry.data(), carry.size());
+            c->size = carry.size();
+            carry.clear();
+            size_t scanned = c->size; // [0, scanned) 中没有换行
+            for (;;)
+            {
+                if (c->size == c->data.size())
+                    c->data.resize(c->data.size() * 2);
+                ssize_t r = ::read(fd, c->data.data() + c->size, c->data.size() - c->size);
+                if (r < 0 && errno == EINTR)
+                    continue;
+                if (r <= 0)
+                {
+                    c->last = true; // 未以换行结尾的末行随最后一块交出
+                    readChunks.push(c);
+                    return;
+                }
+                c->size += static_cast<size_t>(r);
+                const char *nl = static_cast<const char *>(
+                        ::memrchr(c->data.data() + scanned, '\n', c->size - scanned));
+                if (!nl)
+                {
+                    scanned = c->size;
+                    continue;
+                }
+                size_t whole = static_cast<size_t>(nl - c->data.data()) + 1;
+                carry.assign(c->data.data() + whole, c->data.data() + c->size);
+                c->size = whole;
+                break;
+            }
+            readChunks.push(c);
+        }
+    }
+
+    /// 把一行转成命令记录，空白行返回 false；ADDTEAM / START 在此同步队名表副本
+    bool classify(std::string_view line, command &cmd)
+    {
+        cmd = command{line, -1, 0, 0, TokenType::UNKNOWN};
+        tokenstream ts = parser::tokenize(line);
+        token *keyToken = ts.get();
+        if (!keyToken)
+            return false;
+        switch (keyToken->type)
+        {
+            case TokenType::ADDTEAM: {
+                token *nameToken = ts.get();
+                if (!started && nameToken)
+                    names.intern(nameToken->value);
+                break;
+            }
+            case TokenType::START:
+                started = true;
+                break;
+            case TokenType::SUBMIT: {
+                token *problemToken = ts.get();
+                ts.get(); // BY
+                token *teamToken = ts.get();
+                ts.get(); // WITH
+                token *statusToken = ts.get();
+                ts.get(); // AT
+                token *timeToken = ts.get();
+                if (!timeToken || submissionlog::status_code(statusToken->type) == submissionlog::ANY)
+                    break;
+                int problem = problemToken->value[0] - 'A';
+                int teamId = names.find(teamToken->value);
+                if (problem < 0 || problem >= MAX_PROBLEMS || teamId < 0)
+                    break;
+                cmd.teamId = teamId;
+                cmd.problem = problem;
+                cmd.status = statusToken->type;
+                cmd.time = parser::parse_int(timeToken->value);
+                break;
+            }
+            default:
+                break;
+        }
+        return true;
+    }
+
+    /// 解析级：按行切分并转成命令记录，空白行直接丢弃
+    void parse_stage()
+    {
+        for (;;)
+        {
+            chunk *c = readChunks.pop();
+            c->commands.clear();
+            const char *cur = c->data.data();
+            const char *end = cur + c->size;
+            while (cur < end)
+            {
+                const char *nl = static_cast<const char *>(std::memchr(cur, '\n', static_cast<size_t>(end - cur)));
+                const char *lineEnd = nl ? nl : end;
+                std::string_view line(cur, static_cast<size_t>(lineEnd - cur));
+                command cmd;
+                if (classify(line, cmd))
+                    c->commands.push_back(cmd);
+                cur = lineEnd + 1;
+            }
+            bool last = c->last;
+            parsedChunks.push(c);
+            if (last)
+                return;
+        }
+    }
+
+    /// 执行级：在调用线程上按顺序执行，用完的数据块还给读取级
+    void execute_stage()
+    {
+        std::vector<parser::submitrecord> batch; // 连续的已解析 SUBMIT，遇到其他命令或块尾时成批执行
+        for (;;)
+        {
+            chunk *c = parsedChunks.pop();
+            for (const command &cmd: c->commands)
+            {
+                if (cmd.teamId >= 0)
+                {
+                    batch.push_back({cmd.teamId, cmd.problem, cmd.time, cmd.status});
+                    continue;
+                }
+                if (!batch.empty())
+                {
+                    p.execute_submits(batch);
+                    batch.clear();
+                }
+                p.execute(cmd.line);
+            }
+            if (!batch.empty())
+            {
+                p.execute_submits(batch);
+                batch.clear();
+            }
+            if (c->last)
+                return;
+            freeChunks.push(c);
+        }
+    }
+
+public:
+    /// 从 fd 读取命令交给 p 执行；p 可以已经恢复了检查点或回放了事件日志
+    ingestpipeline(parser &p_, int fd_) : p(p_), fd(fd_), names(p_.team_index()), started(p_.started())
+    {
+        for (size_t i = 0; i < CHUNKS; ++i)
+        {
+            pool.push_back(std::make_unique<chunk>());
+            freeChunks.push(pool.back().get());
+        }
+    }
+
+    /// 读到输入结束并执行完全部命令后返回
+    void run()
+    {
+        std::thread reader([this] { read_stage(); });
+        std::thread tokenizer([this] { parse_stage(); });
+        execute_stage();
+        reader.join();
+        tokenizer.join();
+    }
+};
+
+#endif // PIPELINE_HPP
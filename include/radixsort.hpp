@@ -0,0 +1,204 @@
+#pragma once
+#ifndef RADIXSORT_HPP
+#define RADIXSORT_HPP
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include "rankingkey.hpp"
+#include "workerpool.hpp"
+
+/**
+ * 整体重建排名时使用的基数排序
+ * 核心是对 (64 位键, 队伍编号) 记录的稳定 LSD 基数排序：每趟按一个字节分桶，所有记录在该字节上都相同的趟直接跳过；
+ * 每趟先由各工作线程统计自己那一段的桶计数，再按 (桶, 线程) 的顺序求前缀和，各线程把记录分散到互不重叠的位置，
+ * 因此结果与单线程完全相同。
+ *   排名键：最低位的字（队名名次）直接按名次放置，其余从低位的字起逐字做 LSD（只处理有差异的字），
+ *           N 个键 O(N · 变化字节数)
+ *   队名：按 8 字节前缀打包做 LSD，前缀相同的组再取下 8 字节递归，组较小时改用比较排序
+ */
+namespace radixsort
+{
+    struct item
+    {
+        uint64_t key;
+        uint32_t id;
+    };
+
+    constexpr size_t PARALLEL_MIN = 1 << 16; // 记录数少于此值时单线程排序
+    constexpr size_t SMALL_GROUP = 32; // 队名前缀相同的组不超过此大小时直接比较排序
+
+    /// 对 a[0, n) 按 key 稳定排序，tmp 为等长的辅助空间；pool 为空时单线程
+    inline void sort_items(item *a, item *tmp, size_t n, workerpool *pool)
+    {
+        if (n < 2)
+            return;
+        uint64_t diff = 0; // 各记录与首条记录不同的位
+        for (size_t i = 1; i < n; ++i)
+            diff |= a[i].key ^ a[0].key;
+        if (diff == 0)
+            return;
+
+        int threads = (pool && n >= PARALLEL_MIN) ? pool->size() : 1;
+        std::vector<std::array<size_t, 256>> counts(threads);
+        auto range = [n, threads](int t, size_t &lo, size_t &hi) {
+            lo = n * static_cast<size_t>(t) / static_cast<size_t>(threads);
+            hi = n * static_cast<size_t>(t + 1) / static_cast<size_t>(threads);
+        };
+        auto parallel = [&](auto f) {
+            if (threads == 1)
+                f(0);
+            else
+                pool->run([&](int t) { f(t); });
+        };
+
+        item *src = a;
+        item *dst = tmp;
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            if (((diff >> shift) & 0xFF) == 0)
+                continue;
+            parallel([&](int t) {
+                size_t lo, hi;
+                range(t, lo, hi);
+                std::array<size_t, 256> &c = counts[t];
+                c.fill(0);
+                for (size_t i = lo; i < hi; ++i)
+                    c[(src[i].key >> shift) & 0xFF]++;
+            });
+            size_t offset = 0;
+            for (int d = 0; d < 256; ++d)
+            {
+                for (int t = 0; t < threads; ++t)
+                {
+                    size_t c = counts[t][d];
+                    counts[t][d] = offset;
+                    offset += c;
+                }
+            }
+            parallel([&](int t) {
+                size_t lo, hi;
+                range(t, lo, hi);
+                std::array<size_t, 256> &c = counts[t];
+                for (size_t i = lo; i < hi; ++i)
+                    dst[c[(src[i].key >> shift) & 0xFF]++] = src[i];
+            });
+            std::swap(src, dst);
+        }
+        if (src != a)
+            std::memcpy(a, src, n * sizeof(item));
+    }
+
+    /// 把 [0, n) 分成 pool 大小的连续段，各工作者对自己的段调用 f(t, lo, hi)；n 较小或 pool 为空时单线程
+    template<class F>
+    void parallel_for(size_t n, workerpool *pool, F f)
+    {
+        if (!pool || n < PARALLEL_MIN)
+        {
+            f(0, size_t(0), n);
+            return;
+        }
+        size_t threads = static_cast<size_t>(pool->size());
+        pool->run([&](int t) { f(t, n * static_cast<size_t>(t) / threads, n * static_cast<size_t>(t + 1) / threads); });
+    }
+
+    /**
+     * 把编号为 0 .. n-1 的全部队伍按排名键升序排列，写入 ids，keyOf(id) 给出排名键
+     * 排名键的最后一个字是开赛时分配的队名名次，恰为 [0, n) 的一个排列，按它直接放置即完成最低位字的排序；
+     * 其余的字只处理有差异的，从低位到高位逐字取键并做 LSD
+     */
+    template<class KeyOf>
+    void sort_by_key(std::vector<int> &ids, size_t n, KeyOf keyOf, workerpool *pool)
+    {
+        ids.assign(n, 0);
+        if (n < 2)
+            return;
+        constexpr int W = rankingkey::WORDS;
+        const rankingkey first = keyOf(0);
+        std::vector<std::array<bool, W>> varies(pool ? pool->size() : 1, std::array<bool, W>{});
+        parallel_for(n, pool, [&](int t, size_t lo, size_t hi) {
+            std::array<bool, W> &v = varies[t];
+            for (size_t id = lo; id < hi; ++id)
+            {
+                const rankingkey &k = keyOf(static_cast<int>(id));
+                for (int w = 0; w < W - 1; ++w)
+                    v[w] |= k.word_at(w) != first.word_at(w);
+                ids[static_cast<size_t>(k.get_name_rank())] = static_cast<int>(id);
+            }
+        });
+
+        std::vector<item> items(n);
+        std::vector<item> tmp(n);
+        for (int w = W - 2; w >= 0; --w)
+        {
+            if (std::none_of(varies.begin(), varies.end(), [w](const std::array<bool, W> &v) { return v[w]; }))
+                continue;
+            parallel_for(n, pool, [&](int, size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; ++i)
+                    items[i] = {keyOf(ids[i]).word_at(w), static_cast<uint32_t>(ids[i])};
+            });
+            sort_items(items.data(), tmp.data(), n, pool);
+            for (size_t i = 0; i < n; ++i)
+                ids[i] = static_cast<int>(items[i].id);
+        }
+    }
+
+    /// name 自 offset 起的 8 个字节按大端打包，不足补 0（队名不含 0 字节，短者在前）
+    inline uint64_t pack8(std::string_view name, size_t offset)
+    {
+        uint64_t v = 0;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            v <<= 8;
+            if (offset + i < name.size())
+                v |= static_cast<unsigned char>(name[offset + i]);
+        }
+        return v;
+    }
+
+    /// 把 a[0, n)（前 offset 个字节已全部相同）按队名排好序
+    template<class NameOf>
+    void sort_names_from(item *a, item *tmp, size_t n, size_t offset, NameOf nameOf, workerpool *pool)
+    {
+        for (size_t i = 0; i < n; ++i)
+            a[i].key = pack8(nameOf(static_cast<int>(a[i].id)), offset);
+        sort_items(a, tmp, n, pool);
+        for (size_t i = 0; i < n;)
+        {
+            size_t j = i + 1;
+            while (j < n && a[j].key == a[i].key)
+                ++j;
+            if (j - i > 1)
+            {
+                // 组较小，或窗口已越过队名末尾（只有队名含 0 字节时才会出现）时直接比较
+                if (j - i <= SMALL_GROUP || (a[i].key & 0xFF) == 0)
+                    std::sort(a + i, a + j, [&](const item &x, const item &y) {
+                        return nameOf(static_cast<int>(x.id)).substr(offset) <
+                               nameOf(static_cast<int>(y.id)).substr(offset);
+                    });
+                else
+                    sort_names_from(a + i, tmp + i, j - i, offset + 8, nameOf, pool);
+            }
+            i = j;
+        }
+    }
+
+    /// 把 ids 按队名的字典序升序排列（队名互不相同），nameOf(id) 给出队名
+    template<class NameOf>
+    void sort_by_name(std::vector<int> &ids, NameOf nameOf, workerpool *pool)
+    {
+        size_t n = ids.size();
+        std::vector<item> items(n);
+        std::vector<item> tmp(n);
+        for (size_t i = 0; i < n; ++i)
+            items[i].id = static_cast<uint32_t>(ids[i]);
+        sort_names_from(items.data(), tmp.data(), n, 0, nameOf, pool);
+        for (size_t i = 0; i < n; ++i)
+            ids[i] = static_cast<int>(items[i].id);
+    }
+} // namespace radixsort
+
+#endif // RADIXSORT_HPP
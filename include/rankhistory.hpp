@@ -0,0 +1,222 @@
+#pragma once
+#ifndef RANKHISTORY_HPP
+#define RANKHISTORY_HPP
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "rankingkey.hpp"
+
+/**
+ * rankhistory 类
+ * 按时间记录每次通过题目引起的排名键变化，并维护一棵可持久化 treap：
+ * 每次改键以路径复制的方式产生一个新版本，旧版本保持不变，因此可以回答任意时刻的名次。
+ *   改键：O(log N) 时间，新增 O(log N) 个 16 字节的结点
+ *   查询时刻 t 的名次：二分找到版本与该队当时的键 O(log T)，再在该版本中求秩 O(log N)
+ * 这里记录的是真实排名（封榜期间的通过也在其提交时刻生效），供赛后分析使用。
+ */
+class rankhistory
+{
+private:
+    struct node
+    {
+        uint32_t left;
+        uint32_t right;
+        uint32_t key; // keys 中的下标
+        uint32_t size; // 子树大小
+    };
+
+    /// 一支队伍的真实通过情况，用于生成新的排名键
+    struct progress
+    {
+        std::array<int, MAX_PROBLEMS> solved{}; // 首次通过时间（升序，前 count 个有效）
+        int count = 0;
+        int penalty = 0;
+    };
+
+    std::vector<node> pool = std::vector<node>(1, node{0, 0, 0, 0}); // 0 号为空结点
+    std::vector<rankingkey> keys; // 出现过的全部排名键
+    std::vector<uint32_t> roots; // 各版本的根
+    std::vector<int> rootTimes; // 各版本生效的时刻（单调不降）
+    std::vector<std::vector<std::pair<int, uint32_t>>> timeline; // 队伍编号 → (时刻, 键下标)，按时刻有序
+    std::vector<progress> teams;
+    uint32_t fresh = 0; // 下标不小于 fresh 的结点属于正在构造的版本，可以原地修改
+
+    static uint32_t priority(uint32_t k)
+    {
+        k ^= k >> 16;
+        k *= 0x7FEB352Du;
+        k ^= k >> 15;
+        k *= 0x846CA68Bu;
+        return k ^ (k >> 16);
+    }
+
+    uint32_t copy(uint32_t t)
+    {
+        if (t >= fresh)
+            return t;
+        pool.push_back(pool[t]);
+        return static_cast<uint32_t>(pool.size() - 1);
+    }
+
+    void pull(uint32_t t) { pool[t].size = 1 + pool[pool[t].left].size + pool[pool[t].right].size; }
+
+    /// 把 t 分成键小于 key（orEqual 时为不大于）的部分 l 与其余部分 r，沿途结点按需复制
+    void split(uint32_t t, const rankingkey &key, bool orEqual, uint32_t &l, uint32_t &r)
+    {
+        if (t == 0)
+        {
+            l = r = 0;
+            return;
+        }
+        const rankingkey &k = keys[pool[t].key];
+        bool goesLeft = orEqual ? !(key < k) : k < key;
+        uint32_t c = copy(t);
+        uint32_t a, b;
+        if (goesLeft)
+        {
+            split(pool[c].right, key, orEqual, a, b);
+            pool[c].right = a;
+            pull(c);
+            l = c;
+            r = b;
+        }
+        else
+        {
+            split(pool[c].left, key, orEqual, a, b);
+            pool[c].left = b;
+            pull(c);
+            l = a;
+            r = c;
+        }
+    }
+
+    /// 合并 a 与 b（a 中的键全部小于 b 中的键），沿途结点按需复制
+    uint32_t merge(uint32_t a, uint32_t b)
+    {
+        if (a == 0)
+            return b;
+        if (b == 0)
+            return a;
+        if (priority(pool[a].key) > priority(pool[b].key))
+        {
+            uint32_t m = merge(pool[a].right, b);
+            uint32_t c = copy(a);
+            pool[c].right = m;
+            pull(c);
+            return c;
+        }
+        uint32_t m = merge(a, pool[b].left);
+        uint32_t c = copy(b);
+        pool[c].left = m;
+        pull(c);
+        return c;
+    }
+
+    uint32_t make_node(uint32_t key)
+    {
+        pool.push_back(node{0, 0, key, 1});
+        return static_cast<uint32_t>(pool.size() - 1);
+    }
+
+    uint32_t add_key(const rankingkey &k)
+    {
+        keys.push_back(k);
+        return static_cast<uint32_t>(keys.size() - 1);
+    }
+
+    /// 版本 root 中键小于 key 的条目数
+    size_t count_less(uint32_t root, const rankingkey &key) const
+    {
+        size_t r = 0;
+        for (uint32_t t = root; t != 0;)
+        {
+            if (keys[pool[t].key] < key)
+            {
+                r += pool[pool[t].left].size + 1;
+                t = pool[t].right;
+            }
+            else
+            {
+                t = pool[t].left;
+            }
+        }
+        return r;
+    }
+
+public:
+    bool started() const { return !roots.empty(); }
+
+    /**
+     * 开赛时建立第 0 版：order 为按排名键升序排列的队伍编号，keyOf(id) 给出其初始排名键
+     * 初始版本尚未发布，结点原地合并，不产生复制
+     */
+    template<class KeyOf>
+    void start(const std::vector<int> &order, KeyOf keyOf, int time)
+    {
+        size_t n = order.size();
+        teams.assign(n, progress{});
+        timeline.assign(n, {});
+        keys.reserve(n);
+        pool.reserve(n + 1);
+        fresh = 0;
+        uint32_t root = 0;
+        for (int id: order)
+        {
+            uint32_t k = add_key(keyOf(id));
+            timeline[id].push_back({time, k});
+            root = merge(root, make_node(k));
+        }
+        roots.push_back(root);
+        rootTimes.push_back(time);
+    }
+
+    /// 队伍 id 在时刻 time 首次通过一道题，该题罚时为 penalty，产生一个新版本
+    void solve(int id, int time, int penalty)
+    {
+        progress &p = teams[id];
+        int *end = p.solved.data() + p.count;
+        int *it = std::upper_bound(p.solved.data(), end, time);
+        std::copy_backward(it, end, end + 1);
+        *it = time;
+        p.count++;
+        p.penalty += penalty;
+
+        uint32_t oldKey = timeline[id].back().second;
+        rankingkey k = keys[oldKey]; // 沿用队名名次
+        int desc[MAX_PROBLEMS];
+        std::reverse_copy(p.solved.data(), p.solved.data() + p.count, desc);
+        k.set_score(p.count, p.penalty);
+        k.set_times(desc, p.count);
+        uint32_t newKey = add_key(k);
+
+        fresh = static_cast<uint32_t>(pool.size());
+        uint32_t a, b, mid, c;
+        split(roots.back(), keys[oldKey], false, a, b);
+        split(b, keys[oldKey], true, mid, c); // mid 为旧键所在的单个结点
+        uint32_t root = merge(a, c);
+        split(root, k, false, a, b);
+        root = merge(merge(a, make_node(newKey)), b);
+
+        roots.push_back(root);
+        rootTimes.push_back(time);
+        timeline[id].push_back({time, newKey});
+    }
+
+    /// 队伍 id 在时刻 time 结束时的名次（从 1 开始）；time 早于开赛时按开赛时计
+    int rank_at(int id, int time) const
+    {
+        size_t v = static_cast<size_t>(std::upper_bound(rootTimes.begin(), rootTimes.end(), time) - rootTimes.begin());
+        v = v == 0 ? 0 : v - 1;
+        const auto &line = timeline[id];
+        auto it = std::upper_bound(line.begin(), line.end(), time,
+                                   [](int t, const std::pair<int, uint32_t> &e) { return t < e.first; });
+        uint32_t key = it == line.begin() ? line.front().second : std::prev(it)->second;
+        return static_cast<int>(count_less(roots[v], keys[key])) + 1;
+    }
+};
+
+#endif // RANKHISTORY_HPP
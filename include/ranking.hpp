@@ -0,0 +1,27 @@
+#pragma once
+#ifndef RANKING_HPP
+#define RANKING_HPP
+
+/**
+ * 排名索引（rankingindex）的后端在编译期选择
+ * 各后端按 rankingkey 有序存放 (排名键, 队伍编号)，提供相同的接口：
+ *   insert(key, id) / erase(key)      插入、删除一个条目
+ *   update(oldKey, newKey, id)        改键，只有新旧位置之间的名次发生变化
+ *   build(ids, n, keyOf)              由按排名键升序排列的 n 个队伍编号整体建树，O(N)，替换原有内容
+ *   lower_bound(key) / last()         查找第一个不小于 key 的队伍、排名最靠后的队伍（不存在返回 -1）
+ *   rank(key) / at(pos)               排名键严格小于 key 的条目数；第 pos 个条目的迭代器，O(log N)
+ *   begin() / end() / size() / clear() 按排名先后遍历队伍编号
+ *   dirty_begin() / dirty_end()       自上次 clear_dirty 以来名次可能变化的位置区间，为空时 begin >= end
+ *   clear_dirty() / reset_dirty(lo, hi) 清空变化区间、把它置为 [lo, hi)
+ * insert / erase / update / build 都须据所改动的位置扩大变化区间，FLUSH 只改写该区间内的名次。
+ * 默认使用 B+ 树；定义 ICPC_RANKING_RBTREE 时改用结点池红黑树（CMake 选项 ICPC_RANKING_BACKEND=rbtree）。
+ */
+#if defined(ICPC_RANKING_RBTREE)
+#include "rbtree.hpp"
+using rankingindex = rbtree;
+#else
+#include "bptree.hpp"
+using rankingindex = bptree;
+#endif
+
+#endif // RANKING_HPP
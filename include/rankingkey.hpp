@@ -0,0 +1,80 @@
+#pragma once
+#ifndef RANKINGKEY_HPP
+#define RANKINGKEY_HPP
+#include <array>
+#include <cstdint>
+
+/// 题目数量上限（题号 A ~ Z）
+constexpr int MAX_PROBLEMS = 26;
+
+/**
+ * rankingkey 类
+ * 定宽的排名键：各个 64 位字按字典序比较的结果即为队伍的先后顺序，越小越靠前
+ * word[0]：高 32 位为 (MAX_PROBLEMS - 通过题数)，低 32 位为罚时
+ * word[1 .. TIME_WORDS]：已通过题目的通过时间按降序排列，每个占 TIME_BITS 位，从最高位起紧密拼接
+ * word[WORDS - 1]：队名的字典序名次（START 时分配）
+ */
+class rankingkey
+{
+public:
+    static constexpr int TIME_BITS = 17; // 比赛时长不超过 10^5 < 2^17
+    static constexpr int TIME_WORDS = (MAX_PROBLEMS * TIME_BITS + 63) / 64;
+    static constexpr int WORDS = TIME_WORDS + 2;
+
+private:
+    std::array<uint64_t, WORDS> word{};
+
+public:
+    rankingkey() { set_score(0, 0); }
+
+    void set_score(int solved, int penalty)
+    {
+        word[0] = (static_cast<uint64_t>(MAX_PROBLEMS - solved) << 32) | static_cast<uint32_t>(penalty);
+    }
+
+    /**
+     * 重新打包通过时间
+     * times 为按降序排列的 n 个通过时间
+     */
+    void set_times(const int *times, int n)
+    {
+        for (int i = 1; i <= TIME_WORDS; ++i)
+            word[i] = 0;
+        for (int k = 0; k < n; ++k)
+        {
+            uint64_t v = static_cast<uint64_t>(times[k]);
+            int bit = k * TIME_BITS;
+            int w = 1 + bit / 64;
+            int shift = 64 - bit % 64 - TIME_BITS;
+            if (shift >= 0)
+            {
+                word[w] |= v << shift;
+            }
+            else
+            {
+                word[w] |= v >> -shift;
+                word[w + 1] |= v << (64 + shift);
+            }
+        }
+    }
+
+    /// 第 i 个 64 位字，供基数排序逐字取用
+    uint64_t word_at(int i) const { return word[i]; }
+
+    void set_name_rank(int r) { word[WORDS - 1] = static_cast<uint64_t>(r); }
+    int get_name_rank() const { return static_cast<int>(word[WORDS - 1]); }
+
+    friend bool operator<(const rankingkey &a, const rankingkey &b)
+    {
+        for (int i = 0; i < WORDS; ++i)
+        {
+            if (a.word[i] != b.word[i])
+                return a.word[i] < b.word[i];
+        }
+        return false;
+    }
+    friend bool operator==(const rankingkey &a, const rankingkey &b) { return a.word == b.word; }
+    friend bool operator!=(const rankingkey &a, const rankingkey &b) { return !(a == b); }
+};
+
+#endif // RANKINGKEY_HPP
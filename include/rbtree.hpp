@@ -0,0 +1,581 @@
+#pragma once
+#ifndef RBTREE_HPP
+#define RBTREE_HPP
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "rankingkey.hpp"
+
+/**
+ * rbtree 类
+ * 排名索引的红黑树实现：按 rankingkey 有序存放 (排名键, 队伍编号)
+ * 结点放在连续的结点池中，用 32 位下标代替指针互相引用；删除的结点挂入空闲链表复用，
+ * 因此插入、删除不再逐个向系统申请内存。
+ * 每个结点额外记录子树大小（顺序统计树），rank 可在 O(log N) 内求出实时名次。
+ * 同时记录自上次 clear_dirty 以来名次可能变化的位置区间，供增量刷新榜单使用。
+ */
+class rbtree
+{
+private:
+    static constexpr uint32_t NIL = 0; // 哨兵结点（黑色）的下标
+    static constexpr size_t NPOS = SIZE_MAX;
+
+    struct node
+    {
+        rankingkey key;
+        int id = -1;
+        uint32_t left = NIL;
+        uint32_t right = NIL;
+        uint32_t parent = NIL;
+        uint32_t size = 0; // 以该结点为根的子树中的结点数，哨兵恒为 0
+        bool red = false;
+    };
+
+    std::vector<node> pool = std::vector<node>(1); // pool[0] 为哨兵
+    uint32_t root = NIL;
+    uint32_t free_head = NIL; // 空闲结点链表，经由 left 串联
+    size_t count = 0;
+    size_t dirty_lo = NPOS; // 名次可能变化的位置区间 [dirty_lo, dirty_hi)
+    size_t dirty_hi = 0;
+
+    uint32_t alloc(const rankingkey &key, int id)
+    {
+        uint32_t x;
+        if (free_head != NIL)
+        {
+            x = free_head;
+            free_head = pool[x].left;
+        }
+        else
+        {
+            x = static_cast<uint32_t>(pool.size());
+            pool.emplace_back();
+        }
+        node &n = pool[x];
+        n.key = key;
+        n.id = id;
+        n.left = n.right = n.parent = NIL;
+        n.size = 1;
+        n.red = true;
+        return x;
+    }
+
+    void release(uint32_t x)
+    {
+        pool[x].left = free_head;
+        free_head = x;
+    }
+
+    void pull(uint32_t x) { pool[x].size = pool[pool[x].left].size + pool[pool[x].right].size + 1; }
+
+    void rotate_left(uint32_t x)
+    {
+        uint32_t y = pool[x].right;
+        pool[x].right = pool[y].left;
+        if (pool[y].left != NIL)
+            pool[pool[y].left].parent = x;
+        pool[y].parent = pool[x].parent;
+        if (pool[x].parent == NIL)
+            root = y;
+        else if (x == pool[pool[x].parent].left)
+            pool[pool[x].parent].left = y;
+        else
+            pool[pool[x].parent].right = y;
+        pool[y].left = x;
+        pool[x].parent = y;
+        pool[y].size = pool[x].size;
+        pull(x);
+    }
+
+    void rotate_right(uint32_t x)
+    {
+        uint32_t y = pool[x].left;
+        pool[x].left = pool[y].right;
+        if (pool[y].right != NIL)
+            pool[pool[y].right].parent = x;
+        pool[y].parent = pool[x].parent;
+        if (pool[x].parent == NIL)
+            root = y;
+        else if (x == pool[pool[x].parent].right)
+            pool[pool[x].parent].right = y;
+        else
+            pool[pool[x].parent].left = y;
+        pool[y].right = x;
+        pool[x].parent = y;
+        pool[y].size = pool[x].size;
+        pull(x);
+    }
+
+    void insert_fixup(uint32_t z)
+    {
+        while (pool[pool[z].parent].red)
+        {
+            uint32_t p = pool[z].parent;
+            uint32_t g = pool[p].parent;
+            if (p == pool[g].left)
+            {
+                uint32_t y = pool[g].right;
+                if (pool[y].red)
+                {
+                    pool[p].red = false;
+                    pool[y].red = false;
+                    pool[g].red = true;
+                    z = g;
+                }
+                else
+                {
+                    if (z == pool[p].right)
+                    {
+                        z = p;
+                        rotate_left(z);
+                        p = pool[z].parent;
+                    }
+                    pool[p].red = false;
+                    pool[g].red = true;
+                    rotate_right(g);
+                }
+            }
+            else
+            {
+                uint32_t y = pool[g].left;
+                if (pool[y].red)
+                {
+                    pool[p].red = false;
+                    pool[y].red = false;
+                    pool[g].red = true;
+                    z = g;
+                }
+                else
+                {
+                    if (z == pool[p].left)
+                    {
+                        z = p;
+                        rotate_right(z);
+                        p = pool[z].parent;
+                    }
+                    pool[p].red = false;
+                    pool[g].red = true;
+                    rotate_left(g);
+                }
+            }
+        }
+        pool[root].red = false;
+    }
+
+    /// 用以 v 为根的子树替换以 u 为根的子树
+    void transplant(uint32_t u, uint32_t v)
+    {
+        uint32_t p = pool[u].parent;
+        if (p == NIL)
+            root = v;
+        else if (u == pool[p].left)
+            pool[p].left = v;
+        else
+            pool[p].right = v;
+        pool[v].parent = p; // v 可能是哨兵，删除修复时需要它的父结点
+    }
+
+    void erase_fixup(uint32_t x)
+    {
+        while (x != root && !pool[x].red)
+        {
+            uint32_t p = pool[x].parent;
+            if (x == pool[p].left)
+            {
+                uint32_t w = pool[p].right;
+                if (pool[w].red)
+                {
+                    pool[w].red = false;
+                    pool[p].red = true;
+                    rotate_left(p);
+                    w = pool[p].right;
+                }
+                if (!pool[pool[w].left].red && !pool[pool[w].right].red)
+                {
+                    pool[w].red = true;
+                    x = p;
+                }
+                else
+                {
+                    if (!pool[pool[w].right].red)
+                    {
+                        pool[pool[w].left].red = false;
+                        pool[w].red = true;
+                        rotate_right(w);
+                        w = pool[p].right;
+                    }
+                    pool[w].red = pool[p].red;
+                    pool[p].red = false;
+                    pool[pool[w].right].red = false;
+                    rotate_left(p);
+                    x = root;
+                }
+            }
+            else
+            {
+                uint32_t w = pool[p].left;
+                if (pool[w].red)
+                {
+                    pool[w].red = false;
+                    pool[p].red = true;
+                    rotate_right(p);
+                    w = pool[p].left;
+                }
+                if (!pool[pool[w].right].red && !pool[pool[w].left].red)
+                {
+                    pool[w].red = true;
+                    x = p;
+                }
+                else
+                {
+                    if (!pool[pool[w].left].red)
+                    {
+                        pool[pool[w].right].red = false;
+                        pool[w].red = true;
+                        rotate_left(w);
+                        w = pool[p].left;
+                    }
+                    pool[w].red = pool[p].red;
+                    pool[p].red = false;
+                    pool[pool[w].left].red = false;
+                    rotate_right(p);
+                    x = root;
+                }
+            }
+        }
+        pool[x].red = false;
+    }
+
+    uint32_t minimum(uint32_t x) const
+    {
+        while (pool[x].left != NIL)
+            x = pool[x].left;
+        return x;
+    }
+
+    uint32_t maximum(uint32_t x) const
+    {
+        while (pool[x].right != NIL)
+            x = pool[x].right;
+        return x;
+    }
+
+    uint32_t successor(uint32_t x) const
+    {
+        if (pool[x].right != NIL)
+            return minimum(pool[x].right);
+        uint32_t y = pool[x].parent;
+        while (y != NIL && x == pool[y].right)
+        {
+            x = y;
+            y = pool[y].parent;
+        }
+        return y;
+    }
+
+    /// 查找排名键为 key 的结点，pos 为其位置（从 0 开始）
+    uint32_t find(const rankingkey &key, size_t &pos) const
+    {
+        uint32_t x = root;
+        pos = 0;
+        while (x != NIL)
+        {
+            if (key < pool[x].key)
+            {
+                x = pool[x].left;
+            }
+            else if (pool[x].key < key)
+            {
+                pos += pool[pool[x].left].size + 1;
+                x = pool[x].right;
+            }
+            else
+            {
+                pos += pool[pool[x].left].size;
+                return x;
+            }
+        }
+        return NIL;
+    }
+
+    /// 把池中下标 [lo, hi) 的结点（已按键有序）连成平衡子树，返回子树的根
+    uint32_t build_range(size_t lo, size_t hi, uint32_t parent, int depth, int bottom)
+    {
+        if (lo >= hi)
+            return NIL;
+        size_t mid = lo + (hi - lo) / 2;
+        uint32_t x = static_cast<uint32_t>(mid);
+        uint32_t l = build_range(lo, mid, x, depth + 1, bottom);
+        uint32_t r = build_range(mid + 1, hi, x, depth + 1, bottom);
+        node &nd = pool[x];
+        nd.left = l;
+        nd.right = r;
+        nd.parent = parent;
+        nd.red = depth == bottom && depth > 0;
+        pull(x);
+        return x;
+    }
+
+    void mark_dirty(size_t lo, size_t hi)
+    {
+        if (lo >= hi)
+            return;
+        dirty_lo = std::min(dirty_lo, lo);
+        dirty_hi = std::max(dirty_hi, hi);
+    }
+
+    /// 插入条目并返回其位置
+    size_t insert_at(const rankingkey &key, int id)
+    {
+        uint32_t z = alloc(key, id);
+        uint32_t y = NIL;
+        uint32_t x = root;
+        size_t pos = 0;
+        while (x != NIL)
+        {
+            y = x;
+            pool[x].size++;
+            if (key < pool[x].key)
+            {
+                x = pool[x].left;
+            }
+            else
+            {
+                pos += pool[pool[x].left].size + 1;
+                x = pool[x].right;
+            }
+        }
+        pool[z].parent = y;
+        if (y == NIL)
+            root = z;
+        else if (key < pool[y].key)
+            pool[y].left = z;
+        else
+            pool[y].right = z;
+        insert_fixup(z);
+        ++count;
+        return pos;
+    }
+
+    /// 删除排名键为 key 的条目并返回其原位置，不存在返回 NPOS
+    size_t erase_at(const rankingkey &key)
+    {
+        size_t pos;
+        uint32_t z = find(key, pos);
+        if (z == NIL)
+            return NPOS;
+        uint32_t y = (pool[z].left == NIL || pool[z].right == NIL) ? z : minimum(pool[z].right);
+        for (uint32_t p = pool[y].parent; p != NIL; p = pool[p].parent)
+            pool[p].size--; // 实际摘下的位置是 y，其祖先的子树大小各减一
+        y = z;
+        bool y_was_red = pool[y].red;
+        uint32_t x;
+        if (pool[z].left == NIL)
+        {
+            x = pool[z].right;
+            transplant(z, pool[z].right);
+        }
+        else if (pool[z].right == NIL)
+        {
+            x = pool[z].left;
+            transplant(z, pool[z].left);
+        }
+        else
+        {
+            y = minimum(pool[z].right);
+            y_was_red = pool[y].red;
+            x = pool[y].right;
+            if (pool[y].parent == z)
+            {
+                pool[x].parent = y;
+            }
+            else
+            {
+                transplant(y, pool[y].right);
+                pool[y].right = pool[z].right;
+                pool[pool[y].right].parent = y;
+            }
+            transplant(z, y);
+            pool[y].left = pool[z].left;
+            pool[pool[y].left].parent = y;
+            pool[y].red = pool[z].red;
+            pool[y].size = pool[z].size;
+        }
+        if (!y_was_red)
+            erase_fixup(x);
+        pool[NIL].parent = NIL;
+        release(z);
+        --count;
+        return pos;
+    }
+
+public:
+    /// 按排名先后遍历队伍编号
+    class const_iterator
+    {
+    private:
+        const rbtree *tree;
+        uint32_t x;
+
+    public:
+        const_iterator(const rbtree *t, uint32_t n) : tree(t), x(n) {}
+        int operator*() const { return tree->pool[x].id; }
+        const_iterator &operator++()
+        {
+            x = tree->successor(x);
+            return *this;
+        }
+        bool operator==(const const_iterator &o) const { return x == o.x; }
+        bool operator!=(const const_iterator &o) const { return x != o.x; }
+    };
+
+    const_iterator begin() const { return const_iterator(this, root == NIL ? NIL : minimum(root)); }
+    const_iterator end() const { return const_iterator(this, NIL); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    void clear()
+    {
+        pool.resize(1);
+        root = free_head = NIL;
+        count = 0;
+        clear_dirty();
+    }
+
+    /**
+     * 由按排名键升序排列的 n 个队伍编号整体建树，替换原有内容，keyOf(id) 给出排名键
+     * 每次取中点为根，除最底层外各层全满；最底层着红色、其余着黑色即满足红黑性质，O(N)
+     */
+    template<class KeyOf>
+    void build(const int *ids, size_t n, KeyOf keyOf)
+    {
+        clear();
+        pool.reserve(n + 1);
+        for (size_t i = 0; i < n; ++i)
+            alloc(keyOf(ids[i]), ids[i]);
+        int bottom = 0; // 最底层的深度
+        while ((size_t(2) << bottom) <= n)
+            bottom++;
+        root = build_range(1, n + 1, NIL, 0, bottom);
+        count = n;
+        mark_dirty(0, count);
+    }
+
+    /// 插入条目：其后所有位置的名次都会后移
+    void insert(const rankingkey &key, int id)
+    {
+        size_t pos = insert_at(key, id);
+        mark_dirty(pos, count);
+    }
+
+    /// 删除排名键为 key 的条目，不存在则返回 false；其后所有位置的名次都会前移
+    bool erase(const rankingkey &key)
+    {
+        size_t pos = erase_at(key);
+        if (pos == NPOS)
+            return false;
+        mark_dirty(pos, count);
+        return true;
+    }
+
+    /**
+     * 把条目的排名键由 oldKey 改为 newKey
+     * 条目从位置 p 移到 q，只有 [min(p, q), max(p, q)] 内的名次发生变化
+     */
+    void update(const rankingkey &oldKey, const rankingkey &newKey, int id)
+    {
+        size_t p = erase_at(oldKey);
+        size_t q = insert_at(newKey, id);
+        if (p == NPOS)
+            mark_dirty(q, count);
+        else
+            mark_dirty(std::min(p, q), std::max(p, q) + 1);
+    }
+
+    /// 名次可能已变化的位置区间 [dirty_begin(), dirty_end())，区间为空时 begin >= end
+    size_t dirty_begin() const { return dirty_lo; }
+    size_t dirty_end() const { return std::min(dirty_hi, count); }
+    void clear_dirty()
+    {
+        dirty_lo = NPOS;
+        dirty_hi = 0;
+    }
+    /// 把变化区间重置为 [lo, hi)，用于撤销一批改键之后恢复原先的区间
+    void reset_dirty(size_t lo, size_t hi)
+    {
+        clear_dirty();
+        mark_dirty(lo, hi);
+    }
+
+    /// 指向第 pos 个条目（从 0 开始）的迭代器，越界时为 end()
+    const_iterator at(size_t pos) const
+    {
+        uint32_t x = root;
+        while (x != NIL)
+        {
+            size_t l = pool[pool[x].left].size;
+            if (pos < l)
+            {
+                x = pool[x].left;
+            }
+            else if (pos == l)
+            {
+                break;
+            }
+            else
+            {
+                pos -= l + 1;
+                x = pool[x].right;
+            }
+        }
+        return const_iterator(this, x);
+    }
+
+
+    /// 第一个排名键不小于 key 的队伍编号，不存在返回 -1
+    int lower_bound(const rankingkey &key) const
+    {
+        uint32_t x = root;
+        uint32_t res = NIL;
+        while (x != NIL)
+        {
+            if (pool[x].key < key)
+            {
+                x = pool[x].right;
+            }
+            else
+            {
+                res = x;
+                x = pool[x].left;
+            }
+        }
+        return res == NIL ? -1 : pool[res].id;
+    }
+
+    /// 排名键严格小于 key 的条目数，即 key 对应队伍的实时名次减一
+    size_t rank(const rankingkey &key) const
+    {
+        size_t r = 0;
+        uint32_t x = root;
+        while (x != NIL)
+        {
+            if (pool[x].key < key)
+            {
+                r += pool[pool[x].left].size + 1;
+                x = pool[x].right;
+            }
+            else
+            {
+                x = pool[x].left;
+            }
+        }
+        return r;
+    }
+
+    /// 排名最靠后的队伍编号，空树返回 -1
+    int last() const { return root == NIL ? -1 : pool[maximum(root)].id; }
+};
+
+#endif // RBTREE_HPP
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef SPSCRING_HPP
+#define SPSCRING_HPP
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+/**
+ * spscring 类
+ * 单生产者、单消费者的无锁环形队列，容量 N 为 2 的幂
+ * head / tail 各占一条缓存行；双方各自缓存对方的下标，只在看似满（空）时才重新读取，减少缓存行来回迁移
+ * 阻塞版本的 push / pop 先自旋若干次再让出 CPU，核数少于线程数时也不会长时间空转
+ */
+template<class T, size_t N>
+class spscring
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "容量须为 2 的幂");
+
+private:
+    static constexpr size_t MASK = N - 1;
+    static constexpr int SPINS = 64;
+
+    alignas(64) std::atomic<size_t> head{0}; // 下一个出队位置，由消费者推进
+    alignas(64) size_t cachedTail = 0; // 消费者看到的 tail
+    alignas(64) std::atomic<size_t> tail{0}; // 下一个入队位置，由生产者推进
+    alignas(64) size_t cachedHead = 0; // 生产者看到的 head
+    alignas(64) T items[N];
+
+    template<class F>
+    static void wait_until(F ready)
+    {
+        for (int i = 0; !ready(); ++i)
+        {
+            if (i >= SPINS)
+                std::this_thread::yield();
+        }
+    }
+
+public:
+    /// 生产者：队列满时返回 false
+    bool try_push(const T &v)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == N)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == N)
+                return false;
+        }
+        items[t & MASK] = v;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// 消费者：队列空时返回 false
+    bool try_pop(T &v)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail)
+                return false;
+        }
+        v = items[h & MASK];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    void push(const T &v)
+    {
+        wait_until([&] { return try_push(v); });
+    }
+
+    T pop()
+    {
+        T v;
+        wait_until([&] { return try_pop(v); });
+        return v;
+    }
+};
+
+#endif // SPSCRING_HPP
@@ -0,0 +1,199 @@
+#pragma once
+#ifndef STATS_HPP
+#define STATS_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "output.hpp"
+#include "token.hpp"
+
+#if defined(ICPC_STATS)
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * latencyhistogram 类
+ * HDR 风格的对数-线性直方图：每个 2 的幂区间再等分为 2^SUB_BITS 个桶，相对误差不超过 1/2^SUB_BITS
+ * 记录为 O(1)，不保存原始样本
+ */
+class latencyhistogram
+{
+private:
+    static constexpr int SUB_BITS = 5;
+    static constexpr uint64_t SUB = uint64_t(1) << SUB_BITS;
+    static constexpr size_t BUCKETS = 2 * SUB + (63 - SUB_BITS) * SUB;
+
+    std::vector<uint64_t> counts = std::vector<uint64_t>(BUCKETS);
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t maxValue = 0;
+
+    static size_t index_of(uint64_t v)
+    {
+        if (v < 2 * SUB)
+            return static_cast<size_t>(v); // 小值精确计数
+        int e = 63 - __builtin_clzll(v);
+        int k = e - SUB_BITS;
+        return static_cast<size_t>(2 * SUB + (k - 1) * SUB + ((v >> k) - SUB));
+    }
+
+    /// 桶 idx 能容纳的最大值
+    static uint64_t upper_of(size_t idx)
+    {
+        if (idx < 2 * SUB)
+            return idx;
+        size_t k = (idx - 2 * SUB) / SUB + 1;
+        uint64_t sub = (idx - 2 * SUB) % SUB + SUB;
+        return ((sub + 1) << k) - 1;
+    }
+
+public:
+    void record(uint64_t v)
+    {
+        counts[index_of(v)]++;
+        total++;
+        sum += v;
+        if (v > maxValue)
+            maxValue = v;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t mean() const { return total ? sum / total : 0; }
+    uint64_t max() const { return maxValue; }
+
+    /// q 分位数（0 < q <= 1），返回所在桶的上界
+    uint64_t percentile(double q) const
+    {
+        if (total == 0)
+            return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+        if (rank == 0)
+            rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+                return upper_of(i) < maxValue ? upper_of(i) : maxValue;
+        }
+        return maxValue;
+    }
+};
+#endif
+
+/**
+ * commandstats 类
+ * 按命令类型统计执行耗时，并累计排名集合改键次数、滚榜解冻步数
+ * 只有定义 ICPC_STATS 时才真正计时与计数；否则各方法均为空的内联函数，编译后不留任何开销
+ */
+class commandstats
+{
+#if defined(ICPC_STATS)
+private:
+    static constexpr int KINDS = static_cast<int>(TokenType::UNKNOWN) + 1;
+
+    std::vector<latencyhistogram> histograms = std::vector<latencyhistogram>(KINDS);
+    uint64_t reinsertions = 0;
+    uint64_t unfreezeSteps = 0;
+    std::vector<uint64_t> deferred; // 已执行、但实际工作推迟到下一批的命令自身的耗时
+
+    static const char *name_of(TokenType t)
+    {
+        switch (t)
+        {
+            case TokenType::ADDTEAM:
+                return "ADDTEAM";
+            case TokenType::START:
+                return "START";
+            case TokenType::SUBMIT:
+                return "SUBMIT";
+            case TokenType::FLUSH:
+                return "FLUSH";
+            case TokenType::FREEZE:
+                return "FREEZE";
+            case TokenType::SCROLL:
+                return "SCROLL";
+            case TokenType::SCROLL_PREVIEW:
+                return "SCROLL_PREVIEW";
+            case TokenType::QUERY_RANKING:
+                return "QUERY_RANKING";
+            case TokenType::QUERY_SUBMISSION:
+                return "QUERY_SUBMISSION";
+            case TokenType::QUERY_LIVE_RANKING:
+                return "QUERY_LIVE_RANKING";
+            case TokenType::QUERY_HISTORY:
+                return "QUERY_HISTORY";
+            case TokenType::QUERY_BOARD:
+                return "QUERY_BOARD";
+            case TokenType::STATS:
+                return "STATS";
+            case TokenType::CHECKPOINT:
+                return "CHECKPOINT";
+            case TokenType::END:
+                return "END";
+            default:
+                return "UNKNOWN";
+        }
+    }
+
+public:
+#if defined(__x86_64__) || defined(__i386__)
+    static constexpr const char *UNIT = "cycles";
+    static uint64_t now() { return __rdtsc(); }
+#else
+    static constexpr const char *UNIT = "ns";
+    static uint64_t now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now().time_since_epoch())
+                                             .count());
+    }
+#endif
+
+    void record(TokenType type, uint64_t start) { histograms[static_cast<int>(type)].record(now() - start); }
+    /// 记下一条实际工作推迟执行的命令自身的耗时，待 record_batch 时再计入
+    void defer(uint64_t start) { deferred.push_back(now() - start); }
+    /// 从 start 起执行完推迟的一批：批次耗时平均分给各条推迟的命令，与其自身耗时相加后计入 type
+    void record_batch(TokenType type, uint64_t start)
+    {
+        if (deferred.empty())
+            return;
+        uint64_t share = (now() - start) / deferred.size();
+        latencyhistogram &h = histograms[static_cast<int>(type)];
+        for (uint64_t own: deferred)
+            h.record(own + share);
+        deferred.clear();
+    }
+    void count_reinsertion() { reinsertions++; }
+    void count_unfreeze_step() { unfreezeSteps++; }
+
+    /// 输出各命令的耗时分布与计数器，bytesWritten 为累计输出的字节数
+    void report(outputbuffer &out, uint64_t bytesWritten) const
+    {
+        for (int k = 0; k < KINDS; ++k)
+        {
+            const latencyhistogram &h = histograms[k];
+            if (h.count() == 0)
+                continue;
+            out << name_of(static_cast<TokenType>(k)) << " count=" << h.count() << " mean=" << h.mean()
+                << " p50=" << h.percentile(0.50) << " p90=" << h.percentile(0.90) << " p99=" << h.percentile(0.99)
+                << " p999=" << h.percentile(0.999) << " max=" << h.max() << " unit=" << UNIT << "\n";
+        }
+        out << "reinsertions=" << reinsertions << " unfreeze_steps=" << unfreezeSteps
+            << " bytes_written=" << bytesWritten << "\n";
+    }
+#else
+public:
+    static uint64_t now() { return 0; }
+    void record(TokenType, uint64_t) {}
+    void defer(uint64_t) {}
+    void record_batch(TokenType, uint64_t) {}
+    void count_reinsertion() {}
+    void count_unfreeze_step() {}
+#endif
+};
+
+#endif // STATS_HPP
@@ -0,0 +1,151 @@
+#pragma once
+#ifndef STEALINGPOOL_HPP
+#define STEALINGPOOL_HPP
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * stealingpool 类
+ * 工作窃取线程池：每个工作线程有自己的任务队列，外部提交的任务轮流放入各队列，
+ * 工作线程在自己的任务中再提交的任务放回自己的队列。工作线程先从自己队列的队首取任务（先来先做），
+ * 自己的队列空了再从其他队列的队尾窃取，所有队列都空时在条件变量上休眠。
+ * 任务粒度较粗（一次执行若干条命令），队列用互斥锁保护即可，锁只在取放任务时短暂持有。
+ */
+template<class T>
+class stealingpool
+{
+private:
+    struct alignas(64) lane
+    {
+        std::mutex mutex;
+        std::deque<T> tasks;
+    };
+
+    std::function<void(T)> handler;
+    std::vector<std::unique_ptr<lane>> lanes; // 工作线程 w → 它的任务队列
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queued{0}; // 尚在队列中的任务数
+    std::atomic<size_t> outstanding{0}; // 已提交而尚未执行完的任务数
+    std::atomic<size_t> nextLane{0}; // 外部提交时轮流选择队列
+    std::mutex idleMutex;
+    std::condition_variable idleWake; // 有新任务或要求退出
+    std::condition_variable drained; // outstanding 降为 0
+    bool stopping = false;
+
+    /// 当前线程所属的线程池与编号，外部线程为 nullptr
+    static inline thread_local const stealingpool *owner = nullptr;
+    static inline thread_local size_t self = 0;
+
+    bool take(size_t w, T &task)
+    {
+        {
+            lane &own = *lanes[w];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.front());
+                own.tasks.pop_front();
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+        for (size_t k = 1; k < lanes.size(); ++k)
+        {
+            lane &victim = *lanes[(w + k) % lanes.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.back());
+                victim.tasks.pop_back();
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void loop(size_t w)
+    {
+        owner = this;
+        self = w;
+        for (;;)
+        {
+            T task;
+            if (take(w, task))
+            {
+                handler(std::move(task));
+                if (outstanding.fetch_sub(1) == 1)
+                {
+                    std::lock_guard<std::mutex> lock(idleMutex);
+                    drained.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idleMutex);
+            idleWake.wait(lock, [&] { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() == 0)
+                return;
+        }
+    }
+
+public:
+    /// 启动 n 个工作线程（至少 1 个），每个任务交给 handler 执行
+    stealingpool(int n, std::function<void(T)> handler_) : handler(std::move(handler_))
+    {
+        size_t count = n > 1 ? static_cast<size_t>(n) : 1;
+        for (size_t w = 0; w < count; ++w)
+            lanes.push_back(std::make_unique<lane>());
+        for (size_t w = 0; w < count; ++w)
+            threads.emplace_back([this, w] { loop(w); });
+    }
+    stealingpool(const stealingpool &) = delete;
+    stealingpool &operator=(const stealingpool &) = delete;
+    /// 执行完已提交的全部任务后退出
+    ~stealingpool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+            stopping = true;
+        }
+        idleWake.notify_all();
+        for (std::thread &t: threads)
+            t.join();
+    }
+
+    size_t size() const { return threads.size(); }
+
+    /// 提交一个任务：工作线程放入自己的队列，其他线程轮流放入各队列
+    void submit(T task)
+    {
+        size_t w = owner == this ? self : nextLane.fetch_add(1) % lanes.size();
+        outstanding.fetch_add(1);
+        {
+            lane &target = *lanes[w];
+            std::lock_guard<std::mutex> lock(target.mutex);
+            target.tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1);
+        {
+            // 先经过一次 idleMutex 再唤醒：工作线程检查条件与开始休眠之间不会错过这次通知
+            std::lock_guard<std::mutex> lock(idleMutex);
+        }
+        idleWake.notify_one();
+    }
+
+    /// 等待已提交的任务（包括执行中再提交的任务）全部执行完
+    void wait_idle()
+    {
+        std::unique_lock<std::mutex> lock(idleMutex);
+        drained.wait(lock, [&] { return outstanding.load() == 0; });
+    }
+};
+
+#endif // STEALINGPOOL_HPP
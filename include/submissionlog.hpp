@@ -0,0 +1,397 @@
+#pragma once
+#ifndef SUBMISSIONLOG_HPP
+#define SUBMISSIONLOG_HPP
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "rankingkey.hpp"
+#include "token.hpp"
+
+/**
+ * submissionlog 类
+ * 全部提交的只追加日志，每支队伍一段，按 (题目, 状态) 建立索引
+ * 每条提交压缩为一个 32 位记录：时间 << 7 | 题号 << 2 | 状态；队内提交时间单调不降。
+ * 同一队伍同一 (题目, 状态) 的提交串成一条后向链，链上另存 Myers 跳跃指针，
+ * 沿链按时间或序号定位只需 O(log n) 步；各链的链尾与长度经开放寻址表由 (队伍, 题目, 状态) 查得。
+ * 跳跃距离只取决于链内序号，序号在沿链后退时由链长推出，不逐条存放。
+ * 以下 n 为该队提交数，k 为输出条数（FROM/TO）或倒数序号（LAST），c 为参与合并的链数：
+ *   该队全部提交：日志本身按时间有序，区间二分定位 O(log n + k)，倒数第 k 条 O(1)
+ *   指定题目和状态：单条链，区间 O(log n + k)，倒数第 k 条 O(log² n)（逐步推出序号）
+ *   只指定题目（c = 4）或只指定状态（c = MAX_PROBLEMS）：没有按单一维度串起的链，只能合并多条链，
+ *   区间为 O(c log n + k log k)（各链定位后收集命中并排序），倒数第 k 条为 O(c·k)（各链游标逐步后退）；
+ *   另建按题目、按状态的链可把这两种查询也降到单条链，但每条提交要多存两对前驱与跳跃指针
+ * 每队日志按列存放：压缩记录一列、前驱与跳跃指针各一列，每条提交共 12 字节，
+ * 另加每支队伍 16 字节与每个 (队伍, 题目, 状态) 组合 12 字节的链尾表项。
+ * 链尾表按队伍编号分为 SHARDS 个分片：编号模 SHARDS 不同的队伍互不共享任何可写数据，
+ * 在 reserve_teams 之后可由不同线程并发追加。
+ */
+class submissionlog
+{
+public:
+    /// 某次提交的解码结果
+    struct record
+    {
+        int problem;
+        TokenType status;
+        int time;
+    };
+
+    static constexpr int ANY = -1; // 题目或状态不作限制
+    static constexpr int MAX_TIME = (1 << 25) - 1; // 记录中时间占 25 位
+    static constexpr int SHARDS = 64; // 链尾表分片数
+
+    /// 队伍所在的分片
+    static int shard_of(int teamId) { return teamId & (SHARDS - 1); }
+
+private:
+    static constexpr int STATUS_KINDS = 4; // Accepted / Wrong_Answer / Time_Limit_Exceed / Runtime_Error
+    static constexpr int KEYS = MAX_PROBLEMS * STATUS_KINDS; // 每支队伍的链数
+    static constexpr uint32_t NPOS = UINT32_MAX;
+
+    /**
+     * 一支队伍的提交日志，三列共用一次分配：[0, cap) 为压缩记录，[cap, 2cap) 为 prev，[2cap, 3cap) 为 jump
+     * prev / jump 为同链上更早提交在本队日志中的下标：链首的 prev 为 NPOS，jump 指向自身
+     */
+    struct teamlog
+    {
+        std::unique_ptr<uint32_t[]> data;
+        uint32_t size = 0;
+        uint32_t cap = 0;
+
+        const uint32_t *rec() const { return data.get(); }
+        const uint32_t *prev() const { return data.get() + cap; }
+        const uint32_t *jump() const { return data.get() + 2 * static_cast<size_t>(cap); }
+
+        void push(uint32_t r, uint32_t p, uint32_t j)
+        {
+            if (size == cap)
+                grow();
+            data[size] = r;
+            data[cap + size] = p;
+            data[2 * static_cast<size_t>(cap) + size] = j;
+            size++;
+        }
+
+        void grow()
+        {
+            uint32_t n = cap ? cap * 2 : 4;
+            std::unique_ptr<uint32_t[]> fresh(new uint32_t[3 * static_cast<size_t>(n)]);
+            for (size_t c = 0; c < 3; ++c)
+                std::copy(data.get() + c * cap, data.get() + c * cap + size, fresh.get() + c * n);
+            data = std::move(fresh);
+            cap = n;
+        }
+    };
+
+    struct slot
+    {
+        uint32_t key = NPOS; // 队伍编号 * KEYS + 链号，NPOS 表示空槽
+        uint32_t tail = NPOS;
+        uint32_t count = 0; // 链长
+    };
+
+    /// 链尾表的一个分片：开放寻址，容量恒为 2 的幂，装载因子不超过 3/4
+    struct shard
+    {
+        std::vector<slot> table = std::vector<slot>(16);
+        size_t used = 0;
+    };
+
+    std::vector<teamlog> logs; // 队伍编号 → 该队提交日志
+    std::vector<shard> shards = std::vector<shard>(SHARDS);
+
+    static uint32_t pack(int problem, int status, int time)
+    {
+        return (static_cast<uint32_t>(time) << 7) | (static_cast<uint32_t>(problem) << 2) |
+               static_cast<uint32_t>(status);
+    }
+
+    static record unpack(uint32_t r)
+    {
+        return {static_cast<int>((r >> 2) & 31), static_cast<TokenType>(static_cast<int>(TokenType::ACCEPTED) + (r & 3)),
+                static_cast<int>(r >> 7)};
+    }
+
+    /**
+     * 链内序号为 depth 的提交的跳跃距离（链首为 0）
+     * 跳跃指针按斜二进制分解：depth + 1 恰为 2^k 时跳回链首，恰为 2^k - 1 时跳过一半，
+     * 否则去掉不超过它的最大 2^k - 1 后再看余下部分
+     */
+    static uint32_t jump_length(uint32_t depth)
+    {
+        uint64_t n = static_cast<uint64_t>(depth) + 1;
+        for (;;)
+        {
+            if ((n & (n - 1)) == 0)
+                return static_cast<uint32_t>(n - 1);
+            uint64_t m = (uint64_t(1) << (63 - __builtin_clzll(n + 1))) - 1;
+            if (m == n)
+                return static_cast<uint32_t>(n >> 1);
+            n -= m;
+        }
+    }
+
+    static size_t hash_of(uint32_t key)
+    {
+        uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+
+    static void grow(std::vector<slot> &table)
+    {
+        std::vector<slot> old(table.size() * 2);
+        old.swap(table);
+        size_t mask = table.size() - 1;
+        for (const slot &s: old)
+        {
+            if (s.key == NPOS)
+                continue;
+            size_t i = hash_of(s.key) & mask;
+            while (table[i].key != NPOS)
+                i = (i + 1) & mask;
+            table[i] = s;
+        }
+    }
+
+    /// 链尾表项，链不存在时为空槽（tail 为 NPOS，count 为 0）
+    slot tail_of(int teamId, int key) const
+    {
+        uint32_t k = static_cast<uint32_t>(teamId) * KEYS + static_cast<uint32_t>(key);
+        const std::vector<slot> &table = shards[shard_of(teamId)].table;
+        size_t mask = table.size() - 1;
+        for (size_t i = hash_of(k) & mask;; i = (i + 1) & mask)
+        {
+            if (table[i].key == NPOS || table[i].key == k)
+                return table[i];
+        }
+    }
+
+    /// 链尾表项，不存在时新建
+    slot &tail_for(int teamId, int key)
+    {
+        shard &sh = shards[shard_of(teamId)];
+        std::vector<slot> &table = sh.table;
+        if ((sh.used + 1) * 4 > table.size() * 3)
+            grow(table);
+        uint32_t k = static_cast<uint32_t>(teamId) * KEYS + static_cast<uint32_t>(key);
+        size_t mask = table.size() - 1;
+        size_t i = hash_of(k) & mask;
+        while (table[i].key != NPOS)
+        {
+            if (table[i].key == k)
+                return table[i];
+            i = (i + 1) & mask;
+        }
+        sh.used++;
+        table[i].key = k;
+        return table[i];
+    }
+
+    /**
+     * 从 x 沿链向前，返回第一条时间不晚于 to 的提交，不存在返回 NPOS
+     * 跳跃指针目标仍晚于 to 时整段跳过，否则退一步，共 O(log n) 步
+     */
+    static uint32_t seek_time(const teamlog &log, uint32_t x, int to)
+    {
+        const uint32_t *rec = log.rec();
+        const uint32_t *prev = log.prev();
+        const uint32_t *jump = log.jump();
+        while (x != NPOS && time_of(rec[x]) > to)
+        {
+            uint32_t j = jump[x];
+            x = (j != x && time_of(rec[j]) > to) ? j : prev[x];
+        }
+        return x;
+    }
+
+    /// 从链内序号为 depth 的提交 x 沿链向前，返回序号为 target 的提交（target 不大于 depth）
+    static uint32_t seek_depth(const teamlog &log, uint32_t x, uint32_t depth, uint32_t target)
+    {
+        const uint32_t *prev = log.prev();
+        const uint32_t *jump = log.jump();
+        while (depth > target)
+        {
+            uint32_t len = jump_length(depth);
+            if (len > 1 && depth - len >= target)
+            {
+                x = jump[x];
+                depth -= len;
+            }
+            else
+            {
+                x = prev[x];
+                depth--;
+            }
+        }
+        return x;
+    }
+
+    /// 满足条件的各条链号，写入 keys 并返回条数
+    static int keys_of(int problem, int status, int *keys)
+    {
+        int n = 0;
+        for (int p = 0; p < MAX_PROBLEMS; ++p)
+        {
+            if (problem != ANY && p != problem)
+                continue;
+            for (int s = 0; s < STATUS_KINDS; ++s)
+            {
+                if (status == ANY || s == status)
+                    keys[n++] = p * STATUS_KINDS + s;
+            }
+        }
+        return n;
+    }
+
+public:
+    /// 状态对应的编号，非提交状态返回 ANY
+    static int status_code(TokenType t)
+    {
+        int code = static_cast<int>(t) - static_cast<int>(TokenType::ACCEPTED);
+        return (code >= 0 && code < STATUS_KINDS) ? code : ANY;
+    }
+
+    /// 压缩记录中的题号与时间，供检查点恢复前校验
+    static int problem_of(uint32_t rec) { return unpack(rec).problem; }
+    static int time_of(uint32_t rec) { return static_cast<int>(rec >> 7); }
+
+    /// 预先为编号小于 n 的队伍建立日志，之后追加这些队伍的提交不再改动队伍表
+    void reserve_teams(size_t n)
+    {
+        if (logs.size() < n)
+            logs.resize(n);
+    }
+
+    /// 追加一次提交（时间须不早于该队之前的提交）
+    void append(int teamId, int problem, TokenType status, int time)
+    {
+        if (static_cast<size_t>(teamId) >= logs.size())
+            logs.resize(teamId + 1);
+        teamlog &log = logs[teamId];
+        int code = status_code(status);
+        slot &chain = tail_for(teamId, problem * STATUS_KINDS + code);
+        uint32_t pos = log.size;
+        uint32_t jump = pos;
+        if (chain.tail != NPOS)
+        {
+            // 新提交的序号为 count：跳跃距离为 1 时指向前一条，否则沿前一条的跳跃指针再跳两次
+            const uint32_t *jumps = log.jump();
+            jump = jump_length(chain.count) == 1 ? chain.tail : jumps[jumps[chain.tail]];
+        }
+        log.push(pack(problem, code, time), chain.tail, jump);
+        chain.tail = pos;
+        chain.count++;
+    }
+
+    /// 按时间先后对队伍 teamId 的每条压缩记录调用 f(uint32_t)，供检查点写出
+    template<class F>
+    void for_each_packed(int teamId, F f) const
+    {
+        if (static_cast<size_t>(teamId) >= logs.size())
+            return;
+        const teamlog &log = logs[teamId];
+        for (uint32_t i = 0; i < log.size; ++i)
+            f(log.rec()[i]);
+    }
+
+    /// 追加一条由 for_each_packed 给出的压缩记录，供检查点恢复
+    void append_packed(int teamId, uint32_t rec)
+    {
+        record r = unpack(rec);
+        append(teamId, r.problem, r.status, r.time);
+    }
+
+    /**
+     * 按时间先后对满足条件、且时间在 [from, to] 内的每条提交调用 f(record)
+     * problem / status 为 ANY 时不作限制，返回命中条数
+     * 全不限制或全指定时 O(log n + k)，只限制其一时合并 c 条链，O(c log n + k log k)
+     */
+    template<class F>
+    size_t for_each_between(int teamId, int problem, int status, int from, int to, F f) const
+    {
+        if (static_cast<size_t>(teamId) >= logs.size() || from > to)
+            return 0;
+        const teamlog &log = logs[teamId];
+        const uint32_t *rec = log.rec();
+        if (problem == ANY && status == ANY)
+        {
+            const uint32_t *lo = std::lower_bound(rec, rec + log.size, from,
+                                                  [](uint32_t r, int t) { return time_of(r) < t; });
+            const uint32_t *hi = std::upper_bound(lo, rec + log.size, to,
+                                                  [](int t, uint32_t r) { return t < time_of(r); });
+            for (const uint32_t *it = lo; it != hi; ++it)
+                f(unpack(*it));
+            return static_cast<size_t>(hi - lo);
+        }
+
+        int keys[KEYS];
+        int n = keys_of(problem, status, keys);
+        std::vector<uint32_t> hits; // 命中提交在日志中的下标
+        for (int i = 0; i < n; ++i)
+        {
+            uint32_t x = seek_time(log, tail_of(teamId, keys[i]).tail, to);
+            for (; x != NPOS && time_of(rec[x]) >= from; x = log.prev()[x])
+                hits.push_back(x);
+        }
+        std::sort(hits.begin(), hits.end()); // 单链时为逆序，多链时按下标归并
+        for (uint32_t x: hits)
+            f(unpack(rec[x]));
+        return hits.size();
+    }
+
+    /**
+     * 满足条件的倒数第 k 条提交（k 从 1 开始），不存在返回 false
+     * 全不限制时 O(1)，全指定时 O(log² n)，只限制其一时在 c 条链上各退 k 步以内，O(c·k)
+     */
+    bool kth_last(int teamId, int problem, int status, size_t k, record &out) const
+    {
+        if (static_cast<size_t>(teamId) >= logs.size() || k == 0)
+            return false;
+        const teamlog &log = logs[teamId];
+        if (problem == ANY && status == ANY)
+        {
+            if (k > log.size)
+                return false;
+            out = unpack(log.rec()[log.size - k]);
+            return true;
+        }
+
+        int keys[KEYS];
+        int n = keys_of(problem, status, keys);
+        if (n == 1)
+        {
+            slot chain = tail_of(teamId, keys[0]);
+            if (k > chain.count)
+                return false;
+            uint32_t x = seek_depth(log, chain.tail, chain.count - 1, chain.count - static_cast<uint32_t>(k));
+            out = unpack(log.rec()[x]);
+            return true;
+        }
+
+        // 多条链：各链游标从链尾出发，每步取下标最大者后退，共 k 步
+        uint32_t cursor[KEYS];
+        for (int i = 0; i < n; ++i)
+            cursor[i] = tail_of(teamId, keys[i]).tail;
+        for (;;)
+        {
+            int best = -1;
+            for (int i = 0; i < n; ++i)
+            {
+                if (cursor[i] != NPOS && (best < 0 || cursor[i] > cursor[best]))
+                    best = i;
+            }
+            if (best < 0)
+                return false;
+            if (--k == 0)
+            {
+                out = unpack(log.rec()[cursor[best]]);
+                return true;
+            }
+            cursor[best] = log.prev()[cursor[best]];
+        }
+    }
+};
+
+#endif // SUBMISSIONLOG_HPP
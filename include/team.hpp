@@ -2,11 +2,19 @@
 #ifndef TEAM_HPP
 #define TEAM_HPP
 #include <algorithm>
-#include <ostream>
+#include <array>
+#include <charconv>
+#include <cstdint>
 #include <string>
+#include <type_traits>
 #include <utility>
-#include <vector>
+#include "output.hpp"
+#include "rankingkey.hpp"
 #include "token.hpp"
+
+/// 榜单上单道题状态文本的最大长度："-" + 6 位 + "/" + 6 位
+constexpr int MAX_CELL_CHARS = 16;
+
 class team
 {
 private:
@@ -14,56 +22,80 @@ private:
     int rank; // 当前排名
     int solved_count; // 通过题目数
     int time_punishment; // 总罚时
-    bool has_frozen = false; // 是否被冻结
+    uint32_t frozen_mask = 0; // 第 i 位表示第 i 题处于冻结状态
+    /**
+     * 单道题的提交状态，按位压缩为 3 个 64 位字（24 字节）
+     * 计数占 19 位（最多 3×10^5 次提交），时间为 18 位有符号数（-1 表示无，时长不超过 10^5）
+     */
     struct ProblemStatus
     {
-        int state = 0; // 0-未通过 1-已通过 2-被冻结
-        int before_freeze_error_count = 0; // 最后一次封榜前的错误提交次数
-        int error_count = 0; // 错误提交次数
-        int submit_count = 0; // 总提交次数
-        int first_ac_time = -1; // 首次通过时间
-        int last_accept = -1; // 最后一次通过时间
-        int last_wrong = -1; // 最后一次错误时间
-        int last_re = -1; // 最后一次运行时错误时间
-        int last_tle = -1; // 最后一次超时错误时间
-        int last_submit_time = -1; // 该题最近一次提交时间（用于 ALL 状态查询）
-        TokenType last_submit_type = TokenType::UNKNOWN; // 该题最近一次提交类型
-        friend std::ostream &operator<<(std::ostream &os, const ProblemStatus &obj)
+        // 第 1 个字：状态与计数
+        uint64_t state : 2; // 0-未通过 1-已通过 2-被冻结
+        TokenType last_submit_type : 5; // 该题最近一次提交类型（无符号枚举，取值不超过 31）
+        uint64_t error_count : 19; // 错误提交次数
+        uint64_t before_freeze_error_count : 19; // 最后一次封榜前的错误提交次数
+        uint64_t submit_count : 19; // 总提交次数
+        // 第 2 个字
+        int64_t first_ac_time : 18; // 首次通过时间
+        int64_t last_accept : 18; // 最后一次通过时间
+        int64_t last_wrong : 18; // 最后一次错误时间
+        // 第 3 个字
+        int64_t last_re : 18; // 最后一次运行时错误时间
+        int64_t last_tle : 18; // 最后一次超时错误时间
+        int64_t last_submit_time : 18; // 该题最近一次提交时间（用于 ALL 状态查询）
+
+        static_assert(static_cast<int>(TokenType::UNKNOWN) < 32, "last_submit_type 只有 5 位");
+
+        ProblemStatus() :
+            state(0), last_submit_type(TokenType::UNKNOWN), error_count(0), before_freeze_error_count(0),
+            submit_count(0), first_ac_time(-1), last_accept(-1), last_wrong(-1), last_re(-1), last_tle(-1),
+            last_submit_time(-1)
         {
-            if (obj.state == 0)
+        }
+        /**
+         * 把该题在榜单上的显示文本写到 p 处，返回写入的末尾
+         * p 处至少要有 MAX_CELL_CHARS 字节可用
+         */
+        char *format(char *p) const
+        {
+            char *end = p + MAX_CELL_CHARS;
+            int errors = static_cast<int>(error_count);
+            if (state == 0)
             {
-                if (obj.error_count == 0)
-                {
-                    os << '.';
-                }
+                if (errors == 0)
+                    *p++ = '.';
                 else
                 {
-                    os << '-' << obj.error_count;
+                    *p++ = '-';
+                    p = std::to_chars(p, end, errors).ptr;
                 }
             }
-            else if (obj.state == 1)
+            else if (state == 1)
             {
-                if (obj.error_count == 0)
-                {
-                    os << '+';
-                }
-                else
-                {
-                    os << '+' << obj.error_count;
-                }
+                *p++ = '+';
+                if (errors != 0)
+                    p = std::to_chars(p, end, errors).ptr;
             }
             else
             {
-                int post_freeze_submits = obj.submit_count - obj.before_freeze_error_count;
-                if (obj.before_freeze_error_count == 0)
-                {
-                    os << "0/" << post_freeze_submits;
-                }
+                int before = static_cast<int>(before_freeze_error_count);
+                int post_freeze_submits = static_cast<int>(submit_count) - before;
+                if (before == 0)
+                    *p++ = '0';
                 else
                 {
-                    os << '-' << obj.before_freeze_error_count << '/' << post_freeze_submits;
+                    *p++ = '-';
+                    p = std::to_chars(p, end, before).ptr;
                 }
+                *p++ = '/';
+                p = std::to_chars(p, end, post_freeze_submits).ptr;
             }
+            return p;
+        }
+        friend outputbuffer &operator<<(outputbuffer &os, const ProblemStatus &obj)
+        {
+            char tmp[MAX_CELL_CHARS];
+            os.append(tmp, static_cast<size_t>(obj.format(tmp) - tmp));
             return os;
         }
         friend bool operator<(const ProblemStatus &a, const ProblemStatus &b)
@@ -71,34 +103,171 @@ private:
             return a.first_ac_time < b.first_ac_time;
         }
     };
+    static_assert(sizeof(ProblemStatus) == 24, "ProblemStatus should pack into three 64-bit words");
     std::pair<std::pair<int, TokenType>, int> last_submit = {
             {-1, TokenType::UNKNOWN}, -1}; // first.first: 题目序号，first.second: 提交类型，second最后一次提交时间
     std::pair<int, int> last_accept = {-1, -1}; // first: 题目序号， second最后一次通过时间
     std::pair<int, int> last_wrong = {-1, -1}; // first: 题目序号， second最后一次错误时间
     std::pair<int, int> last_re = {-1, -1}; // first: 题目序号， second最后一次运行时错误时间
     std::pair<int, int> last_tle = {-1, -1}; // first: 题目序号， second最后一次超时错误时间
-    std::vector<ProblemStatus> problem_submit_status;
-    std::vector<int> problem_solved; // 已通过的题目首次通过时间（有序）
+    std::array<ProblemStatus, MAX_PROBLEMS> problem_submit_status; // 内联存放，只有前 problem_count 道有效
+    std::array<int, MAX_PROBLEMS> problem_solved{}; // 已通过的题目首次通过时间（升序，前 solved_count 个有效）
+    rankingkey key; // 由通过数、罚时、通过时间与队名名次打包而成，随 add_solved_time 增量更新
+
+    /// 把升序通过时间 asc[0, n) 与罚时写入排名键
+    static void pack_key(rankingkey &k, const int *asc, int n, int penalty)
+    {
+        int desc[MAX_PROBLEMS];
+        std::reverse_copy(asc, asc + n, desc);
+        k.set_score(n, penalty);
+        k.set_times(desc, n);
+    }
+
+    /// 在升序数组 times[0, n) 中插入 t，保持有序
+    static void insert_time(int *times, int n, int t)
+    {
+        int *end = times + n;
+        int *it = std::upper_bound(times, end, t);
+        std::copy_backward(it, end, end + 1);
+        *it = t;
+    }
+
 public:
+    /**
+     * 除队名外的全部状态，定长且可平凡复制，供检查点整块写出与读回
+     */
+    struct image
+    {
+        int32_t rank;
+        int32_t solved_count;
+        int32_t time_punishment;
+        uint32_t frozen_mask;
+        int32_t last_submit[3]; // 题目序号、提交类型、时间
+        int32_t last_accept[2];
+        int32_t last_wrong[2];
+        int32_t last_re[2];
+        int32_t last_tle[2];
+        int32_t reserved;
+        std::array<ProblemStatus, MAX_PROBLEMS> problems;
+        std::array<int32_t, MAX_PROBLEMS> solved;
+        rankingkey key;
+    };
+
+    image save() const
+    {
+        image m;
+        m.rank = rank;
+        m.solved_count = solved_count;
+        m.time_punishment = time_punishment;
+        m.frozen_mask = frozen_mask;
+        m.last_submit[0] = last_submit.first.first;
+        m.last_submit[1] = static_cast<int32_t>(last_submit.first.second);
+        m.last_submit[2] = last_submit.second;
+        m.last_accept[0] = last_accept.first;
+        m.last_accept[1] = last_accept.second;
+        m.last_wrong[0] = last_wrong.first;
+        m.last_wrong[1] = last_wrong.second;
+        m.last_re[0] = last_re.first;
+        m.last_re[1] = last_re.second;
+        m.last_tle[0] = last_tle.first;
+        m.last_tle[1] = last_tle.second;
+        m.reserved = 0;
+        m.problems = problem_submit_status;
+        m.solved = problem_solved;
+        m.key = key;
+        return m;
+    }
+
+    /**
+     * 检查点中的 image 是否自洽，load 之前调用：通过数不超过题目数、冻结位只在前 problem_count 题，
+     * 通过时间升序，排名键除队名名次外与通过数、罚时、通过时间重新打包的结果一致
+     * 否则之后的 add_solved_time 等会越界写入
+     */
+    static bool check_image(const image &m, int problemCount)
+    {
+        if (m.solved_count < 0 || m.solved_count > problemCount || (m.frozen_mask >> problemCount) != 0)
+            return false;
+        const int *asc = m.solved.data();
+        if (!std::is_sorted(asc, asc + m.solved_count) || (m.solved_count > 0 && asc[0] < 0))
+            return false;
+        rankingkey expected = m.key;
+        pack_key(expected, asc, m.solved_count, m.time_punishment);
+        return expected == m.key;
+    }
+
+    void load(const image &m)
+    {
+        rank = m.rank;
+        solved_count = m.solved_count;
+        time_punishment = m.time_punishment;
+        frozen_mask = m.frozen_mask;
+        last_submit = {{m.last_submit[0], static_cast<TokenType>(m.last_submit[1])}, m.last_submit[2]};
+        last_accept = {m.last_accept[0], m.last_accept[1]};
+        last_wrong = {m.last_wrong[0], m.last_wrong[1]};
+        last_re = {m.last_re[0], m.last_re[1]};
+        last_tle = {m.last_tle[0], m.last_tle[1]};
+        problem_submit_status = m.problems;
+        problem_solved = m.solved;
+        key = m.key;
+    }
+
     team() : name(""), rank(0), solved_count(0), time_punishment(0){};
     team(const std::string &team_name) : name(team_name), rank(0), solved_count(0), time_punishment(0){};
     const std::string &get_name() const { return name; }
     int &get_rank() { return rank; }
     const int &get_rank() const { return rank; }
-    int &get_solved_count() { return solved_count; }
     const int &get_solved_count() const { return solved_count; }
-    std::vector<ProblemStatus> &get_submit_status() { return problem_submit_status; }
-    std::vector<int> &get_problem_solved() { return problem_solved; }
-    const std::vector<int> &get_problem_solved() const { return problem_solved; }
-    void add_solved_time(int t)
+    std::array<ProblemStatus, MAX_PROBLEMS> &get_submit_status() { return problem_submit_status; }
+    const std::array<ProblemStatus, MAX_PROBLEMS> &get_submit_status() const { return problem_submit_status; }
+    const rankingkey &get_key() const { return key; }
+    void set_name_rank(int r) { key.set_name_rank(r); }
+    /**
+     * 记录一道新通过的题目
+     * t 为首次通过时间，penalty 为该题罚时；同时更新排名键
+     */
+    void add_solved_time(int t, int penalty)
+    {
+        insert_time(problem_solved.data(), solved_count, t);
+        solved_count++;
+        time_punishment += penalty;
+        pack_key(key, problem_solved.data(), solved_count, time_punishment);
+    }
+    /// 若再通过一道题（通过时间 t、罚时 penalty）后的排名键，不修改队伍本身
+    rankingkey key_with_solved(int t, int penalty) const
     {
-        auto it = std::lower_bound(problem_solved.begin(), problem_solved.end(), t);
-        problem_solved.insert(it, t);
+        int asc[MAX_PROBLEMS];
+        std::copy(problem_solved.data(), problem_solved.data() + solved_count, asc);
+        insert_time(asc, solved_count, t);
+        rankingkey k = key;
+        pack_key(k, asc, solved_count + 1, time_punishment + penalty);
+        return k;
     }
-    int &get_time_punishment() { return time_punishment; }
     const int &get_time_punishment() const { return time_punishment; }
-    bool &get_has_frozen() { return has_frozen; }
-    const bool &get_has_frozen() const { return has_frozen; }
+    bool get_has_frozen() const { return frozen_mask != 0; }
+    /**
+     * 冻结第 idx 题
+     * 封榜后一道未通过的题只要被提交就会冻结，在此之前它的错误次数不会变化，
+     * 因此在首次冻结时记下的错误次数就是封榜时的错误次数（须在计入本次提交之前调用）
+     */
+    void freeze_problem(int idx)
+    {
+        auto &status = problem_submit_status[idx];
+        if (status.state != 2)
+        {
+            status.before_freeze_error_count = status.error_count;
+            status.state = 2;
+        }
+        frozen_mask |= 1u << idx;
+    }
+    /// 编号最小的冻结题，没有则返回 -1
+    int lowest_frozen() const { return frozen_mask ? __builtin_ctz(frozen_mask) : -1; }
+    /// 解冻第 idx 题：封榜期间通过则记为已通过，否则恢复为未通过（不更新罚时与排名键）
+    void unfreeze_problem(int idx)
+    {
+        auto &status = problem_submit_status[idx];
+        status.state = (status.first_ac_time != -1) ? 1 : 0;
+        frozen_mask &= ~(1u << idx);
+    }
     // last_* accessors
     std::pair<std::pair<int, TokenType>, int> &get_last_submit() { return last_submit; }
     std::pair<int, int> &get_last_accept() { return last_accept; }
@@ -110,26 +279,9 @@ public:
     void set_last_wrong(int probIdx, int time) { last_wrong = {probIdx, time}; }
     void set_last_re(int probIdx, int time) { last_re = {probIdx, time}; }
     void set_last_tle(int probIdx, int time) { last_tle = {probIdx, time}; }
-    friend bool operator<(const team &a, const team &b)
-    {
-        if (a.solved_count != b.solved_count)
-        {
-            return a.solved_count > b.solved_count;
-        }
-        if (a.time_punishment != b.time_punishment)
-        {
-            return a.time_punishment < b.time_punishment;
-        }
-        for (auto it_a = a.problem_solved.rbegin(), it_b = b.problem_solved.rbegin();
-             it_a != a.problem_solved.rend() && it_b != b.problem_solved.rend(); ++it_a, ++it_b)
-        {
-            if (*it_a != *it_b)
-            {
-                return *it_a < *it_b;
-            }
-        }
-        return a.name < b.name;
-    }
+    friend bool operator<(const team &a, const team &b) { return a.key < b.key; }
 };
 
+static_assert(std::is_trivially_copyable_v<team::image>, "team::image 须能整块写入检查点");
+
 #endif // TEAM_HPP
@@ -0,0 +1,120 @@
+#pragma once
+#ifndef TEAMINDEX_HPP
+#define TEAMINDEX_HPP
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * teamindex 类
+ * 队名 → 稠密整数编号的驻留表
+ * ADDTEAM 时分配编号（0, 1, 2, ...），之后所有命令只用编号访问队伍。
+ * 采用开放寻址 + 线性探测，直接对 string_view 求哈希，查找时不构造 std::string。
+ */
+class teamindex
+{
+private:
+    struct slot
+    {
+        uint32_t hash = 0;
+        int id = -1; // -1 表示空槽
+    };
+
+    std::vector<slot> slots; // 容量恒为 2 的幂
+    std::string pool; // 所有队名首尾相接存放
+    std::vector<uint32_t> offsets{0}; // 编号 id 的队名位于 pool[offsets[id], offsets[id + 1])
+
+    static uint32_t hash_of(std::string_view sv)
+    {
+        // FNV-1a，末尾再做一次混合，保证低位分布均匀
+        uint64_t h = 1469598103934665603ULL;
+        for (char c: sv)
+        {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ULL;
+        }
+        h ^= h >> 29;
+        return static_cast<uint32_t>(h ^ (h >> 32));
+    }
+
+    void grow()
+    {
+        std::vector<slot> old;
+        old.swap(slots);
+        slots.assign(old.empty() ? 64 : old.size() * 2, slot{});
+        size_t mask = slots.size() - 1;
+        for (const slot &s: old)
+        {
+            if (s.id < 0)
+                continue;
+            size_t i = s.hash & mask;
+            while (slots[i].id >= 0)
+                i = (i + 1) & mask;
+            slots[i] = s;
+        }
+    }
+
+public:
+    teamindex() { grow(); }
+
+    size_t size() const { return offsets.size() - 1; }
+
+    void reserve(size_t n)
+    {
+        while (slots.size() < n * 2)
+            grow();
+        pool.reserve(n * 12);
+        offsets.reserve(n + 1);
+    }
+
+    std::string_view name(int id) const
+    {
+        return std::string_view(pool.data() + offsets[id], offsets[id + 1] - offsets[id]);
+    }
+
+    /// 查找队名对应的编号，不存在返回 -1
+    int find(std::string_view name_) const
+    {
+        uint32_t h = hash_of(name_);
+        size_t mask = slots.size() - 1;
+        for (size_t i = h & mask;; i = (i + 1) & mask)
+        {
+            const slot &s = slots[i];
+            if (s.id < 0)
+                return -1;
+            if (s.hash == h && name(s.id) == name_)
+                return s.id;
+        }
+    }
+
+    /**
+     * 驻留队名
+     * 返回 {编号, 是否为新插入}
+     */
+    std::pair<int, bool> intern(std::string_view name_)
+    {
+        uint32_t h = hash_of(name_);
+        size_t mask = slots.size() - 1;
+        size_t i = h & mask;
+        for (;; i = (i + 1) & mask)
+        {
+            const slot &s = slots[i];
+            if (s.id < 0)
+                break;
+            if (s.hash == h && name(s.id) == name_)
+                return {s.id, false};
+        }
+
+        int id = static_cast<int>(size());
+        pool.append(name_.data(), name_.size());
+        offsets.push_back(static_cast<uint32_t>(pool.size()));
+        slots[i] = slot{h, id};
+        if (size() * 2 > slots.size()) // 装载因子不超过 1/2
+            grow();
+        return {id, true};
+    }
+};
+
+#endif // TEAMINDEX_HPP
@@ -1,9 +1,10 @@
 #ifndef TOKEN_HPP
 #define TOKEN_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string_view>
-#include <vector>
-enum class TokenType
+enum class TokenType : uint8_t
 {
     ADDTEAM,
     START,
@@ -11,8 +12,14 @@ enum class TokenType
     FLUSH,
     FREEZE,
     SCROLL,
+    SCROLL_PREVIEW,
     QUERY_RANKING,
     QUERY_SUBMISSION,
+    QUERY_LIVE_RANKING,
+    QUERY_HISTORY,
+    QUERY_BOARD,
+    STATS,
+    CHECKPOINT,
     END,
 
     ACCEPTED,
@@ -29,17 +36,32 @@ public:
     std::string_view value;
 };
 
+/**
+ * tokenstream 类
+ * 定长、栈上存放的 token 游标：一行命令最多 MAX_TOKENS 个 token，分词过程不做堆分配
+ */
 class tokenstream
 {
+public:
+    /// 最长的命令 QUERY_HISTORY ... FROM t1 TO t2 共 10 个 token
+    static constexpr size_t MAX_TOKENS = 10;
+
 private:
-    std::vector<token> tokens;
+    token tokens[MAX_TOKENS];
+    size_t count = 0;
     size_t currentIndex = 0;
 
 public:
-    tokenstream(const std::vector<token> &tokens) : tokens(tokens) {}
+    bool push(const token &tok)
+    {
+        if (count == MAX_TOKENS)
+            return false;
+        tokens[count++] = tok;
+        return true;
+    }
     const token *peek()
     {
-        if (currentIndex < tokens.size())
+        if (currentIndex < count)
         {
             return &tokens[currentIndex];
         }
@@ -47,7 +69,7 @@ public:
     }
     token *get()
     {
-        if (currentIndex < tokens.size())
+        if (currentIndex < count)
         {
             return &tokens[currentIndex++];
         }
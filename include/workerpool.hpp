@@ -0,0 +1,94 @@
+#pragma once
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * workerpool 类
+ * 固定数量的常驻工作线程，run(f) 在全部 size() 个工作者上各调用一次 f(w) 并等待结束
+ * 调用线程本身充当 0 号工作者，因此只有 size() - 1 个额外线程；size() 为 1 时不创建线程
+ * 任务以函数指针加上下文指针传给工作线程：run 等到全部工作者完成才返回，f 在此期间一直有效，无需拷贝或分配
+ */
+class workerpool
+{
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    void (*job)(void *, int) = nullptr; // 本轮任务：job(context, w)
+    void *context = nullptr;
+    uint64_t generation = 0; // 每次 run 加一，工作线程据此判断有无新任务
+    int running = 0; // 本轮尚未完成的额外线程数
+    bool stopping = false;
+
+    void loop(int w)
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+            lock.unlock();
+            job(context, w);
+            lock.lock();
+            if (--running == 0)
+                done.notify_one();
+        }
+    }
+
+public:
+    explicit workerpool(int n)
+    {
+        for (int w = 1; w < n; ++w)
+            threads.emplace_back([this, w] { loop(w); });
+    }
+    workerpool(const workerpool &) = delete;
+    workerpool &operator=(const workerpool &) = delete;
+    ~workerpool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &t: threads)
+            t.join();
+    }
+
+    int size() const { return static_cast<int>(threads.size()) + 1; }
+
+    /// 在每个工作者上执行 f(w)（w 为 0 到 size() - 1），全部完成后返回
+    template<class F>
+    void run(F &&f)
+    {
+        using Fn = std::remove_reference_t<F>;
+        if (threads.empty())
+        {
+            f(0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = [](void *ctx, int w) { (*static_cast<Fn *>(ctx))(w); };
+            context = const_cast<void *>(static_cast<const void *>(std::addressof(f)));
+            running = static_cast<int>(threads.size());
+            generation++;
+        }
+        wake.notify_all();
+        f(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return running == 0; });
+    }
+};
+
+#endif // WORKERPOOL_HPP
@@ -1,7 +1,16 @@
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
 #include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/boardreplica.hpp"
+#include "../include/contestserver.hpp"
 #include "../include/parser.hpp"
+#include "../include/pipeline.hpp"
 
 // Fast input buffer
 namespace fastio
@@ -30,22 +39,263 @@ namespace fastio
             s.push_back(c);
         }
     }
+
+    /// 逐行读取标准输入并执行（适用于管道）；p 为 parser、多比赛模式的 contestserver 或只读副本 boardreplica
+    template<class Executor>
+    void run(Executor &p)
+    {
+        std::string input;
+        input.reserve(256);
+        while (true)
+        {
+            readline(input);
+            if (input.empty() && p1 == p2)
+                break; // EOF
+            if (!input.empty())
+            {
+                p.execute(input);
+            }
+        }
+    }
 } // namespace fastio
 
-int main()
+// Memory-mapped input: 回放大体积比赛日志时零拷贝地按行切分
+namespace mmapio
+{
+    /**
+     * 将整个文件映射进内存，每行以 string_view 直接交给 parser，不做逐行拷贝
+     * 返回 false 表示文件无法打开或映射
+     */
+    template<class Executor>
+    bool run(Executor &p, const char *path)
+    {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        if (size == 0)
+        {
+            ::close(fd);
+            return true;
+        }
+        void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+            return false;
+        ::madvise(addr, size, MADV_SEQUENTIAL);
+
+        const char *cur = static_cast<const char *>(addr);
+        const char *end = cur + size;
+        while (cur < end)
+        {
+            const char *nl = static_cast<const char *>(std::memchr(cur, '\n', static_cast<size_t>(end - cur)));
+            const char *lineEnd = nl ? nl : end;
+            if (lineEnd != cur)
+            {
+                p.execute(std::string_view(cur, static_cast<size_t>(lineEnd - cur)));
+            }
+            if (!nl)
+                break;
+            cur = nl + 1;
+        }
+        ::munmap(addr, size);
+        return true;
+    }
+} // namespace mmapio
+
+/// 多比赛模式：读取线程分发各行，--workers 个工作线程执行各比赛
+int run_server(const char *dir, const char *inputPath, int workers, bool history, bool singleContestOptions)
+{
+    if (singleContestOptions)
+    {
+        std::fprintf(stderr, "--server cannot be combined with --restore, --replay, --journal, --pipeline or --publish\n");
+        return 2;
+    }
+    struct stat st;
+    if (::stat(dir, &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+        std::fprintf(stderr, "cannot use output directory: %s\n", dir);
+        return 1;
+    }
+    contestserver server(dir, workers, history);
+    if (inputPath)
+    {
+        if (!mmapio::run(server, inputPath))
+        {
+            std::fprintf(stderr, "cannot map input file: %s\n", inputPath);
+            return 1;
+        }
+        return 0;
+    }
+    if (isatty(STDIN_FILENO))
+        server.set_flush_policy(FlushPolicy::PER_COMMAND);
+    fastio::run(server);
+    return 0;
+}
+
+/// 只读副本模式：逐行执行查询，写入方在另一个进程中持续发布榜单
+int run_reader(const char *path, const char *inputPath, bool otherOptions)
+{
+    if (otherOptions)
+    {
+        std::fprintf(stderr, "--reader cannot be combined with options other than --input\n");
+        return 2;
+    }
+    boardreplica replica;
+    if (!replica.open(path))
+    {
+        std::fprintf(stderr, "cannot open board snapshot: %s\n", path);
+        return 1;
+    }
+    if (inputPath)
+    {
+        if (!mmapio::run(replica, inputPath))
+        {
+            std::fprintf(stderr, "cannot map input file: %s\n", inputPath);
+            return 1;
+        }
+        return 0;
+    }
+    if (isatty(STDIN_FILENO))
+        replica.set_flush_policy(FlushPolicy::PER_COMMAND);
+    fastio::run(replica);
+    return 0;
+}
+
+int main(int argc, char **argv)
 {
+    const char *inputPath = nullptr;
+    const char *restorePath = nullptr;
+    const char *journalPath = nullptr;
+    const char *replayPath = nullptr;
+    const char *serverDir = nullptr;
+    const char *publishPath = nullptr;
+    const char *readerPath = nullptr;
+    bool history = false;
+    bool pipelined = false;
+    int workers = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg(argv[i]);
+        if (arg.substr(0, 8) == "--input=")
+        {
+            inputPath = argv[i] + 8;
+        }
+        else if (arg.substr(0, 10) == "--restore=")
+        {
+            restorePath = argv[i] + 10; // 先从检查点恢复比赛状态，再继续执行输入中的命令
+        }
+        else if (arg.substr(0, 10) == "--journal=")
+        {
+            journalPath = argv[i] + 10; // 把执行成功的状态变更命令追加到事件日志
+        }
+        else if (arg.substr(0, 9) == "--replay=")
+        {
+            replayPath = argv[i] + 9; // 在恢复检查点之后、执行输入之前回放事件日志
+        }
+        else if (arg.substr(0, 10) == "--workers=")
+        {
+            workers = std::atoi(argv[i] + 10); // 并行应用 SUBMIT 批的线程数，--server 模式下为执行各比赛的线程数
+        }
+        else if (arg.substr(0, 9) == "--server=")
+        {
+            serverDir = argv[i] + 9; // 多比赛模式：每行以比赛编号开头，各比赛的输出写到该目录下
+        }
+        else if (arg.substr(0, 10) == "--publish=")
+        {
+            publishPath = argv[i] + 10; // 每次 FLUSH 后把榜单发布到该共享内存文件
+        }
+        else if (arg.substr(0, 9) == "--reader=")
+        {
+            readerPath = argv[i] + 9; // 只读副本：在写入方发布的榜单快照上回答查询
+        }
+        else if (arg == "--pipeline")
+        {
+            pipelined = true; // 读取、解析、执行分在三个线程上流水进行
+        }
+        else if (arg == "--history")
+        {
+            history = true; // 记录排名历史，支持 QUERY_RANKING ... AT time
+        }
+        else
+        {
+            std::fprintf(stderr,
+                         "usage: %s [--input=<file>] [--history] [--restore=<checkpoint>] [--replay=<journal>] "
+                         "[--journal=<journal>] [--pipeline] "
+                         "[--workers=<n>] [--server=<output dir>] [--publish=<shm file>] "
+                         "[--reader=<shm file>]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+    if (history && restorePath)
+    {
+        std::fprintf(stderr, "--history cannot be combined with --restore\n");
+        return 2;
+    }
+    if (readerPath)
+        return run_reader(readerPath, inputPath,
+                          history || restorePath || replayPath || journalPath || pipelined || serverDir || publishPath);
+    if (serverDir)
+        return run_server(serverDir, inputPath, workers, history,
+                          restorePath || replayPath || journalPath || pipelined || publishPath);
+
     parser p;
-    std::string input;
-    input.reserve(256);
-    while (true)
+    if (history)
+        p.enable_history();
+    p.set_workers(workers);
+    if (restorePath && !p.restore_checkpoint(restorePath))
+    {
+        std::fprintf(stderr, "cannot restore checkpoint: %s\n", restorePath);
+        return 1;
+    }
+    if (replayPath && p.replay_journal(replayPath) < 0)
+    {
+        std::fprintf(stderr, "cannot replay journal: %s\n", replayPath);
+        return 1;
+    }
+    if (journalPath && !p.open_journal(journalPath))
+    {
+        std::fprintf(stderr, "cannot open journal: %s\n", journalPath);
+        return 1;
+    }
+    if (publishPath && !p.open_publisher(publishPath))
+    {
+        std::fprintf(stderr, "cannot open board snapshot: %s\n", publishPath);
+        return 1;
+    }
+    if (pipelined)
     {
-        fastio::readline(input);
-        if (input.empty() && fastio::p1 == fastio::p2)
-            break; // EOF
-        if (!input.empty())
+        int fd = STDIN_FILENO;
+        if (inputPath && (fd = ::open(inputPath, O_RDONLY)) < 0)
         {
-            p.execute(input);
+            std::fprintf(stderr, "cannot open input file: %s\n", inputPath);
+            return 1;
         }
+        if (isatty(fd))
+            p.set_flush_policy(FlushPolicy::PER_COMMAND);
+        ingestpipeline(p, fd).run();
+        return 0;
     }
+    if (inputPath)
+    {
+        if (!mmapio::run(p, inputPath))
+        {
+            std::fprintf(stderr, "cannot map input file: %s\n", inputPath);
+            return 1;
+        }
+        return 0;
+    }
+
+    // 交互式使用时每条命令立即输出，否则批量写出
+    if (isatty(STDIN_FILENO))
+        p.set_flush_policy(FlushPolicy::PER_COMMAND);
+    fastio::run(p);
     return 0;
 }